@@ -15,7 +15,15 @@ float rand(vec2 value1)
   return fract(sin(dot(value1, vec2(12.9898, 78.233))) * 43758.5453);
 }
 
-const vec3 skyColor = vec3(0.2, 0.3, 0.3);
+layout (std140, binding = 0) uniform Frame
+{
+  mat4  view;
+  mat4  projection;
+  mat4  viewProjection;
+  vec4  skyColor;
+  float fogDensity;
+  float fogGradient;
+};
 
 void main()
 {
@@ -25,6 +33,6 @@ void main()
   float darken = floor(darken_factor / 0.2) * 0.15;
 
   vec3 fragColor = texture(blocksTextureArray, vec3(fragTexCoords, float(fragTexIndex))).rgb  * fragLightLevel * (1.0 - darken);
-  outColor = vec4(mix(skyColor, fragColor, visibility), 1.0);
+  outColor = vec4(mix(skyColor.rgb, fragColor, visibility), 1.0);
 }
 
@@ -12,22 +12,26 @@ flat out float fragDestroyLevel;
 
 out float visibility;
 
-uniform mat4 MVP;
-uniform mat4 MV;
-
-const float fogDensity  = 0.007;
-const float fogGradient = 1.2;
+layout (std140, binding = 0) uniform Frame
+{
+  mat4  view;
+  mat4  projection;
+  mat4  viewProjection;
+  vec4  skyColor;
+  float fogDensity;
+  float fogGradient;
+};
 
 void main()
 {
-  gl_Position = MVP * vec4(vertPos, 1.0);
+  gl_Position = viewProjection * vec4(vertPos, 1.0);
   fragTexCoords    = vertTexCoords;
   fragTexIndex     = vertTexIndex;
   fragLightLevel   = vertLightLevel;
   fragDestroyLevel = vertDestroyLevel;
 
   // Fog
-  vec4 position = MV * vec4(vertPos, 1.0);
+  vec4 position = view * vec4(vertPos, 1.0);
   float dist = length(position.xyz);
 
   visibility = clamp(exp(-pow(dist * fogDensity, fogGradient)), 0.0, 1.0);
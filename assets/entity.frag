@@ -8,12 +8,20 @@ in float visibility;
 
 uniform sampler2D ourTexture;
 
-const vec3 skyColor = vec3(0.2, 0.3, 0.3);
+layout (std140, binding = 0) uniform Frame
+{
+  mat4  view;
+  mat4  projection;
+  mat4  viewProjection;
+  vec4  skyColor;
+  float fogDensity;
+  float fogGradient;
+};
 
 void main()
 {
   vec3 fragColor = texture(ourTexture, fragTexCoords).rgb;
-  outColor = vec4(mix(skyColor, fragColor, visibility), 1.0);
+  outColor = vec4(mix(skyColor.rgb, fragColor, visibility), 1.0);
   outColor = vec4(fragColor, 1.0);
 }
 
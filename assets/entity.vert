@@ -3,25 +3,33 @@ layout (location = 0) in vec3 vertPos;
 layout (location = 1) in vec2 vertNormal;
 layout (location = 2) in vec2 vertTexCoords;
 
+layout (location = 3) in mat4 instanceModel;
+
 out vec2 fragNormal;
 out vec2 fragTexCoords;
 
 out float visibility;
 
-uniform mat4 MVP;
-uniform mat4 MV;
-
-const float fogDensity  = 0.007;
-const float fogGradient = 1.2;
+layout (std140, binding = 0) uniform Frame
+{
+  mat4  view;
+  mat4  projection;
+  mat4  viewProjection;
+  vec4  skyColor;
+  float fogDensity;
+  float fogGradient;
+};
 
 void main()
 {
-  gl_Position = MVP * vec4(vertPos, 1.0);
+  vec4 worldPos = instanceModel * vec4(vertPos, 1.0);
+
+  gl_Position = viewProjection * worldPos;
   fragNormal    = vertNormal;
   fragTexCoords = vertTexCoords;
 
   // Fog
-  vec4 position = MV * vec4(vertPos, 1.0);
+  vec4 position = view * worldPos;
   float dist = length(position.xyz);
 
   visibility = clamp(exp(-pow(dist * fogDensity, fogGradient)), 0.0, 1.0);
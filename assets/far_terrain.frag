@@ -0,0 +1,34 @@
+#version 430 core
+out vec4 outColor;
+
+in vec3      fragPos;
+flat in uint fragTexIndex;
+in float     fragLightLevel;
+
+in float visibility;
+
+uniform sampler2DArray blocksTextureArray;
+
+// Loaded chunks are drawn for real within innerRadius of center
+uniform vec2  center;
+uniform float innerRadius;
+
+layout (std140, binding = 0) uniform Frame
+{
+  mat4  view;
+  mat4  projection;
+  mat4  viewProjection;
+  vec4  skyColor;
+  float fogDensity;
+  float fogGradient;
+};
+
+void main()
+{
+  if(distance(fragPos.xy, center) < innerRadius)
+    discard;
+
+  // One copy of the texture per block, like the top faces of chunks
+  vec3 fragColor = texture(blocksTextureArray, vec3(fragPos.xy, float(fragTexIndex))).rgb * fragLightLevel;
+  outColor = vec4(mix(skyColor.rgb, fragColor, visibility), 1.0);
+}
@@ -0,0 +1,34 @@
+#version 430 core
+layout (location = 0) in vec3 vertPos;
+layout (location = 1) in vec3 vertNormal;
+layout (location = 2) in uint vertTexIndex;
+
+out vec3      fragPos;
+flat out uint fragTexIndex;
+out float     fragLightLevel;
+
+out float visibility;
+
+layout (std140, binding = 0) uniform Frame
+{
+  mat4  view;
+  mat4  projection;
+  mat4  viewProjection;
+  vec4  skyColor;
+  float fogDensity;
+  float fogGradient;
+};
+
+void main()
+{
+  gl_Position = viewProjection * vec4(vertPos, 1.0);
+  fragPos        = vertPos;
+  fragTexIndex   = vertTexIndex;
+  fragLightLevel = 15.0 / 16.0 * (0.5 + 0.5 * vertNormal.z);
+
+  // Fog
+  vec4 position = view * vec4(vertPos, 1.0);
+  float dist = length(position.xyz);
+
+  visibility = clamp(exp(-pow(dist * fogDensity, fogGradient)), 0.0, 1.0);
+}
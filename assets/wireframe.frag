@@ -1,10 +1,9 @@
 #version 430 core
 out vec4 outColor;
 
-uniform vec3 color;
+in vec3 fragColor;
 
 void main()
 {
-  outColor = vec4(color, 1.0f);
+  outColor = vec4(fragColor, 1.0f);
 }
-
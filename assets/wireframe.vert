@@ -1,10 +1,24 @@
 #version 430 core
 layout (location = 0) in vec3 vertPos;
 
-uniform mat4 MVP;
+layout (location = 1) in vec3 instancePosition;
+layout (location = 2) in vec3 instanceDimension;
+layout (location = 3) in vec3 instanceColor;
+
+out vec3 fragColor;
+
+layout (std140, binding = 0) uniform Frame
+{
+  mat4  view;
+  mat4  projection;
+  mat4  viewProjection;
+  vec4  skyColor;
+  float fogDensity;
+  float fogGradient;
+};
 
 void main()
 {
-  gl_Position = MVP * vec4(vertPos, 1.0);
+  gl_Position = viewProjection * vec4(instancePosition + vertPos * instanceDimension, 1.0);
+  fragColor   = instanceColor;
 }
-
@@ -0,0 +1,204 @@
+/*
+ * Cost per entity of voxel collision at low and high velocity. Entities are
+ * spread over a flat floor and given random velocities of up to a few
+ * different magnitudes, and a single tick is timed from the same starting
+ * world every time. Runs on one thread, so the numbers are per entity cost
+ * and not thread scaling, which is what bench/physics_stress.cpp is for.
+ *
+ * The reference is the resolution update_physics used to do: every voxel in
+ * the swept box is collected into a vector, sorted by distance to the
+ * entity, and resolved in that order. update_physics is timed as a whole, so
+ * its numbers also include the broadphase, which the reference skips.
+ */
+#include <physics.hpp>
+
+#include <omp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <optional>
+#include <random>
+#include <cstdio>
+
+static constexpr int    REGION_RADIUS = 3;    // In chunks, around the origin
+static constexpr int    FLOOR_HEIGHT  = 20;
+static constexpr size_t ENTITY_COUNT  = 4000;
+static constexpr int    REPEAT_COUNT  = 5;
+static constexpr float  DT            = 1.0f / 20.0f;
+
+static constexpr float MAX_VELOCITIES[] = { 1.0f, 50.0f, 300.0f };
+
+using Clock = std::chrono::steady_clock;
+
+static World make_world(float max_velocity)
+{
+  World world;
+  for(int cy=-REGION_RADIUS; cy<REGION_RADIUS; ++cy)
+    for(int cx=-REGION_RADIUS; cx<REGION_RADIUS; ++cx)
+    {
+      Chunk& chunk = world.chunks[glm::ivec2(cx, cy)];
+      for(int z=0; z<CHUNK_HEIGHT; ++z)
+        for(int y=0; y<CHUNK_WIDTH; ++y)
+          for(int x=0; x<CHUNK_WIDTH; ++x)
+            chunk.blocks[z][y][x] = Block{ .id = z < FLOOR_HEIGHT ? BLOCK_ID_STONE : BLOCK_ID_NONE, .sky = 0, .light_level = 0, .destroy_level = 0 };
+      update_occupancy(chunk);
+      update_lod(chunk);
+    }
+
+  // Entities start just above the floor, so that most of them are about to
+  // hit it whatever their velocity
+  std::mt19937                          prng(1);
+  std::uniform_real_distribution<float> horizontal(-REGION_RADIUS * CHUNK_WIDTH + 1.0f, REGION_RADIUS * CHUNK_WIDTH - 2.0f);
+  std::uniform_real_distribution<float> velocity(-max_velocity, max_velocity);
+  for(size_t i=0; i<ENTITY_COUNT; ++i)
+  {
+    Transform transform = { .position = glm::vec3(horizontal(prng), horizontal(prng), FLOOR_HEIGHT + 0.5f), .rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f) };
+    world.entities.create(0, transform, glm::vec3(0.9f, 0.9f, 1.9f), 1.5f);
+    world.entities.physics.velocities.back() = glm::vec3(velocity(prng), velocity(prng), velocity(prng));
+  }
+  return world;
+}
+
+namespace reference
+{
+  static constexpr float FRICTION_AIR      = 0.03f;
+  static constexpr float FRICTION_GROUNDED = 0.05f;
+  static constexpr float GRAVITY           = 9.8f;
+
+  struct SweptAABBResult
+  {
+    float t_in;  glm::vec3 normal_in;
+    float t_out; glm::vec3 normal_out;
+  };
+
+  static std::optional<SweptAABBResult> swept_aabb(AABB box1, AABB box2, glm::vec3 direction)
+  {
+    if(direction == glm::vec3(0.0f))
+      return std::nullopt;
+
+    glm::vec3 ds_in  = box2.position - (box1.position + box1.dimension);
+    glm::vec3 ds_out = (box2.position + box2.dimension) - box1.position;
+
+    SweptAABBResult result = {
+      .t_in  = -std::numeric_limits<float>::infinity(),
+      .t_out = +std::numeric_limits<float>::infinity(),
+    };
+    for(int i=0; i<3; ++i)
+    {
+      float d_in  = ds_in[i];
+      float d_out = ds_out[i];
+      if(direction[i] != 0.0f)
+      {
+        float t1 = d_in  / direction[i];
+        float t2 = d_out / direction[i];
+
+        float t_min = std::min(t1, t2);
+        float t_max = std::max(t1, t2);
+
+        if(result.t_in < t_min)
+        {
+          result.t_in         = t_min;
+          result.normal_in    = {};
+          result.normal_in[i] = direction[i] > 0.0f ? -1.0f : 1.0f;
+        }
+
+        if(result.t_out > t_max)
+        {
+          result.t_out         = t_max;
+          result.normal_out    = {};
+          result.normal_out[i] = direction[i] > 0.0f ? 1.0f : -1.0f;
+        }
+      }
+      else if(d_in * d_out >= 0.0f)
+        return std::nullopt;
+    }
+    return result;
+  }
+
+  static void entity_update_physics(const World& world, Entities::Physics& physics, size_t index, float dt)
+  {
+    glm::vec3& velocity = physics.velocities[index];
+    velocity   -= dt * (physics.grounded[index] ? FRICTION_GROUNDED : FRICTION_AIR) * velocity;
+    velocity.z -= dt * GRAVITY;
+
+    AABB entity_aabb = entity_get_aabb(world.entities, index);
+    glm::vec3 direction = dt * velocity;
+
+    glm::vec3 corner1 = entity_aabb.position                                    ;
+    glm::vec3 corner2 = entity_aabb.position                         + direction;
+    glm::vec3 corner3 = entity_aabb.position + entity_aabb.dimension            ;
+    glm::vec3 corner4 = entity_aabb.position + entity_aabb.dimension + direction;
+
+    glm::ivec3 corner_min = glm::floor(glm::min(glm::min(glm::min(corner1, corner2), corner3), corner4));
+    glm::ivec3 corner_max = glm::ceil (glm::max(glm::max(glm::max(corner1, corner2), corner3), corner4));
+
+    struct Item
+    {
+      glm::ivec3 position;
+      float      distance;
+    };
+    std::vector<Item> items;
+    for(int z = corner_min.z; z<=corner_max.z; ++z)
+      for(int y = corner_min.y; y<=corner_max.y; ++y)
+        for(int x = corner_min.x; x<=corner_max.x; ++x)
+          items.push_back(Item{
+            .position = glm::ivec3(x, y, z),
+            .distance = glm::length(glm::vec3(x, y, z) - physics.positions[index]),
+          });
+
+    std::sort(items.begin(), items.end(), [](const Item& lhs, const Item& rhs) { return lhs.distance < rhs.distance; });
+
+    for(const Item& item : items)
+      if(const Block* block = get_block(world, item.position); block && block->id != BLOCK_ID_NONE)
+      {
+        AABB block_aabb = { .position = item.position, .dimension = glm::vec3(1.0f), };
+        if(std::optional<SweptAABBResult> result = swept_aabb(entity_aabb, block_aabb, direction))
+          if(0.0f <= result->t_in && result->t_in <= 1.0f)
+          {
+            direction -= glm::dot(direction, result->normal_in) * result->normal_in * (1.0f - result->t_in);
+            velocity  -= glm::dot(velocity,  result->normal_in) * result->normal_in;
+
+            physics.collided[index] = true;
+            if(result->normal_in.z > 0.0f)
+              physics.grounded[index] = true;
+          }
+      }
+
+    physics.positions[index] += direction;
+  }
+
+  static void update_physics(World& world, float dt)
+  {
+    for(size_t i=0; i<world.entities.size(); ++i)
+      entity_update_physics(world, world.entities.physics, i, dt);
+  }
+}
+
+template<typename F>
+static double time_tick_us(const World& initial_world, F update)
+{
+  double total_us = 0.0;
+  for(int i=0; i<REPEAT_COUNT; ++i)
+  {
+    World world = initial_world;
+    Clock::time_point begin = Clock::now();
+    update(world, DT);
+    total_us += std::chrono::duration<double, std::micro>(Clock::now() - begin).count();
+  }
+  return total_us / REPEAT_COUNT;
+}
+
+int main()
+{
+  omp_set_num_threads(1);
+
+  std::printf("%zu entities, one thread\n", ENTITY_COUNT);
+  for(float max_velocity : MAX_VELOCITIES)
+  {
+    const World initial_world = make_world(max_velocity);
+    double reference_us = time_tick_us(initial_world, reference::update_physics) / ENTITY_COUNT;
+    double current_us   = time_tick_us(initial_world, update_physics)            / ENTITY_COUNT;
+    std::printf("velocity components up to %3.0f: distance sort %8.3f us/entity, update_physics %8.3f us/entity, speedup = %.2fx\n", max_velocity, reference_us, current_us, reference_us / current_us);
+  }
+}
@@ -0,0 +1,102 @@
+/*
+ * 10k entity stress scenario for update_physics. Entities are dropped onto a
+ * flat floor spanning REGION_WIDTH^2 chunks, and the average tick time is
+ * reported for every thread count from 1 to omp_get_max_threads(). Every run
+ * starts from the same world, so the runs do the same work.
+ *
+ * Also reports how long an OpenMP parallel region that does next to nothing
+ * takes, which is what running a tick's collisions in parallel costs on top
+ * of the work itself.
+ */
+#include <physics.hpp>
+
+#include <omp.h>
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+static constexpr int    REGION_WIDTH = 8;    // In chunks
+static constexpr int    FLOOR_HEIGHT = 64;
+static constexpr size_t ENTITY_COUNT = 10000;
+static constexpr int    TICK_COUNT   = 100;
+static constexpr float  DT           = 1.0f / 20.0f;
+
+using Clock = std::chrono::steady_clock;
+
+static World make_world()
+{
+  World world;
+  for(int cy=0; cy<REGION_WIDTH; ++cy)
+    for(int cx=0; cx<REGION_WIDTH; ++cx)
+    {
+      Chunk& chunk = world.chunks[glm::ivec2(cx, cy)];
+      for(int z=0; z<CHUNK_HEIGHT; ++z)
+        for(int y=0; y<CHUNK_WIDTH; ++y)
+          for(int x=0; x<CHUNK_WIDTH; ++x)
+            chunk.blocks[z][y][x] = Block{ .id = z < FLOOR_HEIGHT ? BLOCK_ID_STONE : BLOCK_ID_NONE, .sky = 0, .light_level = 0, .destroy_level = 0 };
+      update_occupancy(chunk);
+      update_lod(chunk);
+    }
+
+  // Spawn everything within the floor, falling from different heights and
+  // drifting sideways, so that entities land and come to rest over the run
+  std::mt19937                          prng(42);
+  std::uniform_real_distribution<float> horizontal(1.0f, REGION_WIDTH * CHUNK_WIDTH - 2.0f);
+  std::uniform_real_distribution<float> vertical(FLOOR_HEIGHT + 1.0f, FLOOR_HEIGHT + 40.0f);
+  std::uniform_real_distribution<float> drift(-2.0f, 2.0f);
+  for(size_t i=0; i<ENTITY_COUNT; ++i)
+  {
+    Transform transform = { .position = glm::vec3(horizontal(prng), horizontal(prng), vertical(prng)), .rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f) };
+    world.entities.create(0, transform, glm::vec3(0.5f, 0.5f, 0.5f), 0.25f);
+    world.entities.physics.velocities.back() = glm::vec3(drift(prng), drift(prng), 0.0f);
+  }
+  return world;
+}
+
+int main()
+{
+  const World initial_world = make_world();
+
+  int max_thread_count = omp_get_max_threads();
+  std::printf("%zu entities, %d ticks, %d hardware threads\n", ENTITY_COUNT, TICK_COUNT, omp_get_num_procs());
+
+  double serial_ms = 0.0;
+  for(int thread_count=1; thread_count<=max_thread_count; ++thread_count)
+  {
+    omp_set_num_threads(thread_count);
+
+    World world = initial_world;
+    Clock::time_point begin = Clock::now();
+    for(int tick=0; tick<TICK_COUNT; ++tick)
+      update_physics(world, DT);
+    double tick_ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count() / TICK_COUNT;
+
+    if(thread_count == 1)
+      serial_ms = tick_ms;
+
+    // The checksum must not depend on the thread count
+    size_t awake_count = 0;
+    double checksum    = 0.0;
+    for(size_t i=0; i<world.entities.size(); ++i)
+    {
+      awake_count += !world.entities.physics.sleeping[i];
+      checksum    += world.entities.physics.positions[i].x + world.entities.physics.positions[i].y + world.entities.physics.positions[i].z;
+    }
+
+    std::printf("threads = %2d: %8.3f ms/tick, speedup = %.2fx, %zu entities still awake, checksum = %.6f\n", thread_count, tick_ms, serial_ms / tick_ms, awake_count, checksum);
+  }
+
+  omp_set_num_threads(max_thread_count);
+  static constexpr int REGION_COUNT = 10000;
+  std::atomic<int> thread_sum = 0;
+  Clock::time_point begin = Clock::now();
+  for(int i=0; i<REGION_COUNT; ++i)
+  {
+#pragma omp parallel
+    thread_sum.fetch_add(1, std::memory_order_relaxed);
+  }
+  double region_us = std::chrono::duration<double, std::micro>(Clock::now() - begin).count() / REGION_COUNT;
+  std::printf("trivial parallel region with %d threads: %.2f us (%d thread entries)\n", max_thread_count, region_us, thread_sum.load());
+}
@@ -0,0 +1,260 @@
+/*
+ * Ray casts of length 20, 100 and 500 through open terrain and through caves.
+ * The world is rolling terrain over CHUNK_RADIUS chunks around the origin,
+ * with spherical caves dug into it. Open terrain rays start above the ground
+ * and look slightly downwards. Cave rays start in the air inside a cave and
+ * point in any direction, so they mostly hit a wall within a few blocks.
+ *
+ * The reference is a plain DDA that looks up every block along the ray,
+ * caching only the current chunk, and skips nothing. Results must be the same as the reference, except for rays
+ * that pass exactly through an edge or corner, where the two may step across
+ * the boundaries in a different order. Mismatches are reported and should
+ * stay a tiny fraction of the rays.
+ */
+#include <ray_cast.hpp>
+
+#include <coordinates.hpp>
+
+#include <glm/gtx/norm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <cstdio>
+
+static constexpr int    CHUNK_RADIUS = 12;
+static constexpr int    CAVE_COUNT   = 3000;
+static constexpr size_t RAY_COUNT    = 20000;
+static constexpr int    REPEAT_COUNT = 7;
+
+static constexpr float RAY_LENGTHS[] = { 20.0f, 100.0f, 500.0f };
+
+using Clock = std::chrono::steady_clock;
+
+struct Cave
+{
+  glm::vec3 center;
+  float     radius;
+};
+
+static int terrain_height(int x, int y)
+{
+  return 60 + static_cast<int>(4.0f * std::sin(x * 0.05f) + 4.0f * std::cos(y * 0.07f));
+}
+
+static World make_world(std::mt19937& prng, std::vector<Cave>& caves)
+{
+  World world;
+  for(int cy=-CHUNK_RADIUS; cy<CHUNK_RADIUS; ++cy)
+    for(int cx=-CHUNK_RADIUS; cx<CHUNK_RADIUS; ++cx)
+    {
+      Chunk& chunk = world.chunks[glm::ivec2(cx, cy)];
+      for(int z=0; z<CHUNK_HEIGHT; ++z)
+        for(int y=0; y<CHUNK_WIDTH; ++y)
+          for(int x=0; x<CHUNK_WIDTH; ++x)
+          {
+            bool solid = z < terrain_height(cx * CHUNK_WIDTH + x, cy * CHUNK_WIDTH + y);
+            chunk.blocks[z][y][x] = Block{ .id = solid ? BLOCK_ID_STONE : BLOCK_ID_NONE, .sky = 0, .light_level = 0, .destroy_level = 0 };
+          }
+    }
+
+  std::uniform_real_distribution<float> horizontal(-CHUNK_RADIUS * CHUNK_WIDTH, CHUNK_RADIUS * CHUNK_WIDTH);
+  std::uniform_real_distribution<float> vertical(10.0f, 50.0f);
+  std::uniform_real_distribution<float> radius(2.0f, 6.0f);
+  for(int i=0; i<CAVE_COUNT; ++i)
+  {
+    Cave cave = { .center = glm::vec3(horizontal(prng), horizontal(prng), vertical(prng)), .radius = radius(prng) };
+    glm::ivec3 min = glm::floor(cave.center - cave.radius);
+    glm::ivec3 max = glm::ceil (cave.center + cave.radius);
+    for(int z=min.z; z<=max.z; ++z)
+      for(int y=min.y; y<=max.y; ++y)
+        for(int x=min.x; x<=max.x; ++x)
+          if(glm::length2(glm::vec3(x, y, z) - cave.center) < cave.radius * cave.radius)
+            if(Block *block = get_block(world, glm::ivec3(x, y, z)))
+              block->id = BLOCK_ID_NONE;
+    caves.push_back(cave);
+  }
+
+  for(auto& [chunk_index, chunk] : world.chunks)
+    update_occupancy(chunk);
+
+  return world;
+}
+
+static std::vector<Ray> make_open_rays(std::mt19937& prng, float length)
+{
+  std::uniform_real_distribution<float> horizontal(-80.0f, 80.0f);
+  std::uniform_real_distribution<float> vertical(70.0f, 90.0f);
+  std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+  std::vector<Ray> rays;
+  while(rays.size() < RAY_COUNT)
+  {
+    glm::vec3 d = glm::vec3(direction(prng), direction(prng), -0.3f * std::abs(direction(prng)));
+    if(d == glm::vec3(0.0f))
+      continue;
+    rays.push_back(Ray{ .position = glm::vec3(horizontal(prng), horizontal(prng), vertical(prng)), .direction = glm::normalize(d), .length = length });
+  }
+  return rays;
+}
+
+static std::vector<Ray> make_cave_rays(std::mt19937& prng, const World& world, const std::vector<Cave>& caves, float length)
+{
+  std::uniform_int_distribution<size_t> cave_index(0, caves.size() - 1);
+  std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+  std::vector<Ray> rays;
+  while(rays.size() < RAY_COUNT)
+  {
+    glm::vec3 position = caves[cave_index(prng)].center;
+    glm::vec3 d        = glm::vec3(direction(prng), direction(prng), direction(prng));
+    if(std::abs(position.x) > 150.0f || std::abs(position.y) > 150.0f || d == glm::vec3(0.0f))
+      continue;
+
+    const Block *block = get_block(world, glm::ivec3(glm::floor(position)));
+    if(!block || block->id != BLOCK_ID_NONE)
+      continue;
+
+    rays.push_back(Ray{ .position = position, .direction = glm::normalize(d), .length = length });
+  }
+  return rays;
+}
+
+namespace reference
+{
+  // The chunk cache and DDA ray_cast_blocks used before it skipped anything,
+  // so that the comparison is only about the skipping
+  class ChunkCache
+  {
+  public:
+    ChunkCache(const World& world) : m_world(world), m_chunk_index(), m_chunk(nullptr), m_valid(false) {}
+
+  public:
+    const Block *get_block(glm::ivec3 position)
+    {
+      if(position.z < 0 || position.z >= CHUNK_HEIGHT)
+        return nullptr;
+
+      auto [local_position, chunk_index] = coordinates::split(position);
+      if(!m_valid || m_chunk_index != chunk_index)
+      {
+        auto it = m_world.chunks.find(chunk_index);
+        m_chunk_index = chunk_index;
+        m_chunk       = it != m_world.chunks.end() ? &it->second : nullptr;
+        m_valid       = true;
+      }
+      return m_chunk ? &m_chunk->blocks[local_position.z][local_position.y][local_position.x] : nullptr;
+    }
+
+  private:
+    const World& m_world;
+    glm::ivec2   m_chunk_index;
+    const Chunk *m_chunk;
+    bool         m_valid;
+  };
+
+  static RayCastBlocksResult ray_cast_blocks(ChunkCache& cache, const Ray& ray)
+  {
+    RayCastBlocksResult result = {};
+    glm::ivec3 iposition = glm::floor(ray.position);
+    if(const Block *block = cache.get_block(iposition); block && block->id != BLOCK_ID_NONE)
+    {
+      result.type     = RayCastBlocksResult::Type::INSIDE_BLOCK;
+      result.position = iposition;
+      return result;
+    }
+
+    glm::ivec3 steps   = glm::ivec3(0);
+    glm::vec3  t_maxs  = glm::vec3(std::numeric_limits<float>::infinity());
+    glm::vec3  t_delta = glm::vec3(std::numeric_limits<float>::infinity());
+    for(int i=0; i<3; ++i)
+    {
+      if(ray.direction[i] == 0.0f)
+        continue;
+
+      steps[i]   = ray.direction[i] < 0.0f ? -1 : 1;
+      t_maxs[i]  = (iposition[i] + (steps[i] > 0 ? 1 : 0) - ray.position[i]) / ray.direction[i];
+      t_delta[i] = 1.0f / std::abs(ray.direction[i]);
+    }
+
+    for(;;)
+    {
+      int min_i = 0;
+      for(int i=1; i<3; ++i)
+        if(t_maxs[min_i] > t_maxs[i])
+          min_i = i;
+
+      if(ray.length < t_maxs[min_i])
+      {
+        result.type = RayCastBlocksResult::Type::NONE;
+        return result;
+      }
+
+      iposition[min_i] += steps[min_i];
+      t_maxs[min_i]    += t_delta[min_i];
+      if(const Block *block = cache.get_block(iposition); block && block->id != BLOCK_ID_NONE)
+      {
+        result.type          = RayCastBlocksResult::Type::HIT;
+        result.position      = iposition;
+        result.normal        = glm::ivec3(0);
+        result.normal[min_i] = -steps[min_i];
+        return result;
+      }
+    }
+  }
+}
+
+static bool same_result(const RayCastBlocksResult& a, const RayCastBlocksResult& b)
+{
+  if(a.type != b.type)
+    return false;
+  if(a.type == RayCastBlocksResult::Type::NONE)
+    return true;
+  return a.position == b.position && (a.type == RayCastBlocksResult::Type::INSIDE_BLOCK || a.normal == b.normal);
+}
+
+int main()
+{
+  std::mt19937      prng(3);
+  std::vector<Cave> caves;
+  const World world = make_world(prng, caves);
+
+  std::printf("%zu rays per case, %dx%d chunks, %d caves\n", RAY_COUNT, 2 * CHUNK_RADIUS, 2 * CHUNK_RADIUS, CAVE_COUNT);
+  for(float length : RAY_LENGTHS)
+    for(bool cave : { false, true })
+    {
+      std::vector<Ray> rays = cave ? make_cave_rays(prng, world, caves, length) : make_open_rays(prng, length);
+
+      // Best of several runs, alternating between the two, as the cases are
+      // short enough for noise to matter
+      std::vector<RayCastBlocksResult> expected(rays.size());
+      std::vector<RayCastBlocksResult> results(rays.size());
+      double reference_us = std::numeric_limits<double>::infinity();
+      double current_us   = std::numeric_limits<double>::infinity();
+      for(int repeat=0; repeat<REPEAT_COUNT; ++repeat)
+      {
+        Clock::time_point reference_begin = Clock::now();
+        reference::ChunkCache cache(world);
+        for(size_t i=0; i<rays.size(); ++i)
+          expected[i] = reference::ray_cast_blocks(cache, rays[i]);
+        reference_us = std::min(reference_us, std::chrono::duration<double, std::micro>(Clock::now() - reference_begin).count() / rays.size());
+
+        Clock::time_point begin = Clock::now();
+        ray_cast_blocks(world, rays, results);
+        current_us = std::min(current_us, std::chrono::duration<double, std::micro>(Clock::now() - begin).count() / rays.size());
+      }
+
+      size_t hit_count      = 0;
+      size_t mismatch_count = 0;
+      for(size_t i=0; i<rays.size(); ++i)
+      {
+        hit_count      += expected[i].type != RayCastBlocksResult::Type::NONE;
+        mismatch_count += !same_result(expected[i], results[i]);
+      }
+
+      std::printf("length %3.0f, %-12s: %5zu hits, %zu mismatches, plain DDA %6.3f us/ray, ray_cast_blocks %6.3f us/ray, speedup = %.2fx\n",
+        length, cave ? "caves" : "open terrain", hit_count, mismatch_count, reference_us, current_us, reference_us / current_us);
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ * SpatialHash broadphase against brute force. For every entity count, boxes
+ * the size of a player are scattered over an area that grows with the count,
+ * so density stays the same, and the overlapping pairs are found both ways.
+ * The two sets of pairs must be identical, and the time taken by each is
+ * reported.
+ *
+ * Exits with a non-zero status if the pairs differ for any entity count.
+ */
+#include <spatial_hash.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <cstdio>
+
+static constexpr size_t ENTITY_COUNTS[] = { 1000, 10000, 30000 };
+static constexpr int    REPEAT_COUNT    = 10;
+
+using Clock = std::chrono::steady_clock;
+using Pairs = std::vector<std::pair<std::uint32_t, std::uint32_t>>;
+
+static std::vector<AABB> make_aabbs(size_t count)
+{
+  std::mt19937                          prng(2);
+  float                                 extent = 2.0f * std::sqrt(static_cast<float>(count));
+  std::uniform_real_distribution<float> horizontal(-extent, extent);
+  std::uniform_real_distribution<float> vertical(0.0f, 10.0f);
+
+  std::vector<AABB> aabbs;
+  for(size_t i=0; i<count; ++i)
+    aabbs.push_back(AABB{ .position = glm::vec3(horizontal(prng), horizontal(prng), vertical(prng)), .dimension = glm::vec3(0.9f, 0.9f, 1.9f) });
+  return aabbs;
+}
+
+static Pairs brute_force_pairs(const std::vector<AABB>& aabbs)
+{
+  Pairs pairs;
+  for(std::uint32_t i=0; i<aabbs.size(); ++i)
+    for(std::uint32_t j=i+1; j<aabbs.size(); ++j)
+      if(aabb_overlap(aabbs[i], aabbs[j]))
+        pairs.emplace_back(i, j);
+  return pairs;
+}
+
+int main()
+{
+  bool success = true;
+  for(size_t entity_count : ENTITY_COUNTS)
+  {
+    std::vector<AABB> aabbs = make_aabbs(entity_count);
+
+    // Brute force is quadratic, so it is only run once
+    Clock::time_point brute_force_begin = Clock::now();
+    Pairs expected = brute_force_pairs(aabbs);
+    double brute_force_ms = std::chrono::duration<double, std::milli>(Clock::now() - brute_force_begin).count();
+
+    SpatialHash spatial_hash;
+    Pairs       pairs;
+    Clock::time_point spatial_hash_begin = Clock::now();
+    for(int i=0; i<REPEAT_COUNT; ++i)
+    {
+      pairs.clear();
+      spatial_hash.rebuild(aabbs);
+      spatial_hash.query_pairs(pairs);
+    }
+    double spatial_hash_ms = std::chrono::duration<double, std::milli>(Clock::now() - spatial_hash_begin).count() / REPEAT_COUNT;
+
+    bool equal = pairs == expected;
+    success = success && equal;
+    std::printf("%5zu entities: %6zu pairs, brute force %9.3f ms, spatial hash (rebuild + query_pairs) %7.3f ms, speedup = %7.1fx, pairs %s\n",
+      entity_count, expected.size(), brute_force_ms, spatial_hash_ms, brute_force_ms / spatial_hash_ms, equal ? "identical" : "DIFFER");
+  }
+  return success ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+struct AABB
+{
+  glm::vec3 position;
+  glm::vec3 dimension;
+};
+
+inline bool aabb_overlap(const AABB& aabb1, const AABB& aabb2)
+{
+  glm::vec3 min = glm::max(aabb1.position,                   aabb2.position);
+  glm::vec3 max = glm::min(aabb1.position + aabb1.dimension, aabb2.position + aabb2.dimension);
+  for(int i=0; i<3; ++i)
+    if(min[i] >= max[i])
+      return false;
+  return true;
+}
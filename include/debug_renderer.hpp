@@ -4,7 +4,10 @@
 #include <graphics/ui_renderer.hpp>
 #include <graphics/font.hpp>
 
-#include <world.hpp>
+#include <render_snapshot.hpp>
+#include <world_renderer.hpp>
+#include <thread_pool.hpp>
+#include <timer.hpp>
 
 class DebugRenderer
 {
@@ -15,17 +18,26 @@ public:
 
   static constexpr size_t DT_AVERAGE_COUNT = 32;
 
+  static constexpr float THREAD_POOL_STATS_INTERVAL = 1.0f;
+
 public:
   DebugRenderer();
 
 public:
   void update(float dt);
-  void render(glm::vec2 viewport, const World& world, graphics::UIRenderer& ui_renderer);
+  void render(glm::vec2 viewport, const RenderSnapshot& snapshot, const Timer::Stats& tick_stats, const WorldRenderer::Stats& world_renderer_stats, graphics::UIRenderer& ui_renderer);
 
 private:
-  void render_line(glm::vec2 viewport, size_t n, const std::string& line, graphics::UIRenderer& ui_renderer);
+  void render_line(size_t n, const std::string& line, graphics::UIRenderer& ui_renderer);
+  size_t render_thread_pool_stats(size_t n, graphics::UIRenderer& ui_renderer);
+  size_t render_profiler_stats(size_t n, graphics::UIRenderer& ui_renderer);
+  size_t render_memory_stats(size_t n, graphics::UIRenderer& ui_renderer);
 
 private:
   std::unique_ptr<graphics::Font> m_font;
   float m_dts[DT_AVERAGE_COUNT];
+
+  ThreadPool::Stats                 m_thread_pool_stats;
+  ThreadPool::Clock::time_point     m_thread_pool_stats_time;
+  std::vector<float>                m_thread_pool_utilisations;
 };
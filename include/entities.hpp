@@ -0,0 +1,95 @@
+#pragma once
+
+#include <transform.hpp>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Stable reference to an entity. The generation is bumped whenever a slot is
+ * reused, so a handle to a destroyed entity never aliases a newer one.
+ */
+struct EntityHandle
+{
+  std::uint32_t slot;
+  std::uint32_t generation;
+
+  friend bool operator==(const EntityHandle&, const EntityHandle&) = default;
+};
+
+/*
+ * Structure-of-arrays entity storage. Live entities are packed densely in
+ * every component array, so each system can stream through only the arrays
+ * it needs. Dense indices are invalidated by create() and destroy(), which
+ * moves the last entity into the hole. Anything that needs to refer to an
+ * entity across those calls should hold an EntityHandle instead.
+ *
+ * The component arrays are public so that systems can iterate them
+ * directly, but they must only be resized through create() and destroy().
+ */
+class Entities
+{
+public:
+  // Hot data touched every tick by update_physics
+  struct Physics
+  {
+    std::vector<glm::vec3>    positions;
+    std::vector<glm::vec3>    velocities;
+    std::vector<glm::vec3>    dimensions;
+    std::vector<std::uint8_t> collided;
+    std::vector<std::uint8_t> grounded;
+
+    // Consecutive ticks an entity has spent resting on the ground. Once it
+    // reaches SLEEP_TICKS the entity is put to sleep and skipped by physics
+    // until something wakes it up again.
+    std::vector<std::uint8_t> idle_ticks;
+    std::vector<std::uint8_t> sleeping;
+  };
+
+  // Orientation, only needed for player control and rendering
+  struct Transforms
+  {
+    std::vector<glm::quat> rotations;
+    std::vector<float>     eyes;
+  };
+
+  struct Render
+  {
+    std::vector<std::uint16_t> ids;
+  };
+
+public:
+  EntityHandle create(std::uint16_t id, Transform transform, glm::vec3 dimension, float eye);
+  void destroy(EntityHandle handle);
+
+public:
+  size_t size() const { return m_dense_slots.size(); }
+
+  bool         valid (EntityHandle handle) const;
+  size_t       index (EntityHandle handle) const;
+  EntityHandle handle(size_t index) const;
+
+public:
+  Transform transform(size_t index) const;
+  void set_transform(size_t index, const Transform& transform);
+
+public:
+  Physics    physics;
+  Transforms transforms;
+  Render     render;
+
+private:
+  struct Slot
+  {
+    std::uint32_t index;
+    std::uint32_t generation;
+  };
+
+  std::vector<Slot>          m_slots;
+  std::vector<std::uint32_t> m_free_slots;
+  std::vector<std::uint32_t> m_dense_slots;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <world_generator.hpp>
+#include <resource_pack.hpp>
+#include <lazy.hpp>
+
+#include <graphics/camera.hpp>
+#include <graphics/mesh_arena.hpp>
+#include <graphics/shader_program.hpp>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+
+#include <unordered_map>
+#include <memory>
+#include <vector>
+
+#include <cstdint>
+
+/*
+ * Cheap horizon beyond the loaded chunks. The world is split into square
+ * regions of REGION_WIDTH chunks, and every region within RADIUS regions of
+ * the camera is drawn as a low resolution heightfield tile sampled directly
+ * from the terrain height maps, without ever generating any block.
+ *
+ * Tiles are built on the thread pool, cached while they stay in range, and all
+ * drawn from a single MeshArena. Only a few are queued at a time, nearest
+ * first, since the thread pool is FIFO and chunk generation queued behind a
+ * full ring of tiles would otherwise have to wait for all of them. Fragments over loaded chunks are discarded,
+ * so that the tiles never cover the real terrain.
+ */
+class FarTerrainRenderer
+{
+public:
+  static constexpr int REGION_WIDTH      = 8;  // In chunks
+  static constexpr int REGION_RESOLUTION = 16; // Quads on a side of a tile
+  static constexpr int RADIUS            = 8;  // In regions
+
+  static constexpr size_t MAX_PENDING_TILE_COUNT = 4;
+
+  // Statistics about the last call to render()
+  struct Stats
+  {
+    size_t tile_count;
+    size_t tile_pending_count;
+    size_t tile_culled_count;
+    size_t vertex_count;
+  };
+
+public:
+  FarTerrainRenderer(const WorldGenerationConfig& config);
+
+public:
+  // Chunks within inner_radius blocks of center are assumed to be loaded
+  void render(const graphics::Camera& camera, const ResourcePack& resource_pack, glm::vec2 center, float inner_radius);
+  const Stats& stats() const { return m_stats; }
+
+private:
+  struct TileSample
+  {
+    glm::vec3     position;
+    glm::vec3     normal;
+    std::uint32_t block_id;
+  };
+
+  struct TileData
+  {
+    std::vector<TileSample> samples;
+    float                   min_height;
+    float                   max_height;
+  };
+
+  struct Tile
+  {
+    std::unique_ptr<Lazy<TileData>> pending;
+
+    graphics::MeshArena::Allocation allocation;
+    float                           min_height;
+    float                           max_height;
+  };
+
+  static TileData generate_tile(const TerrainSampler& sampler, glm::ivec2 region);
+
+private:
+  std::shared_ptr<const TerrainSampler> m_sampler;
+
+  std::unique_ptr<graphics::ShaderProgram> m_shader_program;
+  std::unique_ptr<graphics::MeshArena>     m_arena;
+
+  std::vector<glm::ivec2>                            m_region_offsets;
+  std::unordered_map<glm::ivec2, Tile>               m_tiles;
+  std::vector<graphics::DrawElementsIndirectCommand> m_draw_commands;
+
+  Stats m_stats;
+};
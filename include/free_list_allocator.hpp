@@ -0,0 +1,49 @@
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <optional>
+
+#include <cstddef>
+
+/*
+ * Sub-allocates ranges out of a linear space of a given capacity, such as a
+ * GPU buffer. Units are whatever the caller wants them to be. Allocation is
+ * best-fit, and freed ranges are merged with their free neighbours so that
+ * the space does not fragment into ever smaller pieces.
+ *
+ * This only does the bookkeeping and never touches the underlying storage.
+ */
+class FreeListAllocator
+{
+public:
+  FreeListAllocator(size_t capacity);
+
+public:
+  // Returns the offset of the allocated range, or nothing if there is no
+  // free range large enough. Allocating zero units always fails.
+  std::optional<size_t> allocate(size_t size);
+  void free(size_t offset);
+
+  // Extend the space at the end. Existing allocations are left alone.
+  void grow(size_t capacity);
+
+public:
+  size_t capacity()     const { return m_capacity; }
+  size_t used()         const { return m_used; }
+  size_t free_count()   const { return m_free_by_offset.size(); }
+  size_t largest_free() const;
+
+private:
+  void insert_free(size_t offset, size_t size);
+  void erase_free(std::map<size_t, size_t>::iterator it);
+
+private:
+  size_t m_capacity;
+  size_t m_used;
+
+  std::map<size_t, size_t>      m_free_by_offset; // offset -> size
+  std::multimap<size_t, size_t> m_free_by_size;   // size -> offset
+
+  std::unordered_map<size_t, size_t> m_allocations; // offset -> size
+};
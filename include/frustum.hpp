@@ -0,0 +1,24 @@
+#pragma once
+
+#include <aabb.hpp>
+
+#include <glm/glm.hpp>
+
+/*
+ * View frustum as six inward facing planes, extracted directly from a
+ * view-projection matrix (Gribb & Hartmann). A point p is inside a plane
+ * (n, d) iff dot(n, p) + d >= 0.
+ *
+ * This only does math on matrices, so it can be used and tested without a
+ * GL context.
+ */
+struct Frustum
+{
+  glm::vec4 planes[6];
+
+  static Frustum from_matrix(const glm::mat4& view_projection);
+
+  // Conservative, so some boxes just outside a corner of the frustum are
+  // reported as intersecting
+  bool intersects(const AABB& aabb) const;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <graphics/texture.hpp>
+#include <graphics/ui_batch.hpp>
 #include <graphics/ui_renderer.hpp>
 
 #include <glm/glm.hpp>
@@ -9,23 +10,23 @@
 
 namespace graphics
 {
+  /*
+   * All the glyphs of a font are packed into a single atlas texture, so that
+   * any amount of text can be drawn with one call.
+   */
   struct Font
   {
+  public:
+    static constexpr unsigned ATLAS_WIDTH = 512;
+
   public:
     Font(const char *font, unsigned height);
 
   public:
-    void render(UIRenderer& renderer, glm::vec2 viewport, glm::vec2 position, const char* str);
+    void render(UIRenderer& renderer, glm::vec2 position, const char* str) const;
 
   private:
-    struct Glyph
-    {
-      glm::ivec3 dimenson;
-      glm::vec2  bearing;
-      glm::vec2  advance;
-
-      std::unique_ptr<graphics::Texture> texture;
-    };
-    Glyph m_glyphs[128];
+    Glyph                              m_glyphs[128];
+    std::unique_ptr<graphics::Texture> m_atlas;
   };
 }
@@ -0,0 +1,52 @@
+#ifndef FRAME_UNIFORMS_HPP
+#define FRAME_UNIFORMS_HPP
+
+#include <graphics/camera.hpp>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+namespace graphics
+{
+  static constexpr float     FOG_DENSITY  = 0.0025f;
+  static constexpr float     FOG_GRADIENT = 1.2f;
+  static constexpr glm::vec3 SKY_COLOR    = glm::vec3(0.2f, 0.3f, 0.3f);
+
+  /*
+   * Data shared by every program drawing the scene, laid out like the std140
+   * Frame uniform block declared at binding FrameUniformBuffer::BINDING in
+   * the shaders.
+   */
+  struct FrameUniforms
+  {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 view_projection;
+    glm::vec4 sky_color;
+    float     fog_density;
+    float     fog_gradient;
+    float     padding[2];
+  };
+
+  // Uploaded once per frame, and bound for all programs at once
+  class FrameUniformBuffer
+  {
+  public:
+    static constexpr GLuint BINDING = 0;
+
+  public:
+    FrameUniformBuffer();
+    ~FrameUniformBuffer();
+
+    FrameUniformBuffer(const FrameUniformBuffer&) = delete;
+    FrameUniformBuffer& operator=(const FrameUniformBuffer&) = delete;
+
+  public:
+    void update(const Camera& camera);
+
+  private:
+    GLuint m_ubo;
+  };
+}
+
+#endif // FRAME_UNIFORMS_HPP
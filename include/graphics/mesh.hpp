@@ -42,6 +42,17 @@ namespace graphics
     size_t        offset;
   };
 
+  // Point the attributes at the currently bound GL_ARRAY_BUFFER, in the
+  // currently bound vertex array, starting at the given location. Attributes
+  // with a non-zero divisor advance once per that many instances instead of
+  // once per vertex.
+  void configure_attributes(size_t stride, std::span<const Attribute> attributes, GLuint first_location = 0, GLuint divisor = 0);
+
+  // STATIC and DYNAMIC meshes keep their buffers between writes and only
+  // reallocate them when the data no longer fits. STREAM meshes are meant to
+  // be rewritten every frame, and write into a persistently mapped ring of
+  // buffer segments so that a write never waits for the GPU to finish drawing
+  // the previous contents.
   enum class Usage {
     STATIC,
     DYNAMIC,
@@ -50,9 +61,24 @@ namespace graphics
 
   struct Mesh
   {
+  public:
+    // Number of segments in the ring used by Usage::STREAM, which should be at
+    // least the number of frames the GPU can lag behind
+    static constexpr size_t STREAM_SEGMENT_COUNT = 3;
+
+    struct Stats
+    {
+      size_t write_count;
+      size_t allocation_count; // Buffer (re)allocations, orphaning included
+      size_t wait_count;       // Stream writes that had to wait on a fence
+    };
+
   public:
     static std::unique_ptr<Mesh> load_from(const std::string& filename);
 
+    // Summed over every mesh since startup
+    static const Stats& total_stats();
+
   public:
     Mesh(IndexType index_type, PrimitiveType primitive_type, size_t stride, std::span<const Attribute> attributes);
     ~Mesh();
@@ -60,15 +86,62 @@ namespace graphics
   public:
     void write(std::span<const std::byte> indices, std::span<const std::byte> vertices, Usage usage);
     void draw() const;
+    void draw(size_t first, size_t count) const; // Range in number of indices
+
+    // Per-instance attributes, which come after the vertex attributes. The
+    // instance buffer keeps its capacity between writes like the others.
+    void set_instance_layout(size_t stride, std::span<const Attribute> attributes);
+    void write_instances(std::span<const std::byte> instances, Usage usage);
+    void draw_instanced(size_t first_instance, size_t instance_count) const;
+
+    const Stats& stats() const { return m_stats; }
 
   private:
-    IndexType     m_index_type;
-    PrimitiveType m_primitive_type;
-    size_t        m_element_count;
+    struct Buffer
+    {
+      GLuint     id;
+      size_t     capacity; // In bytes, per segment if streaming
+      std::byte *mapping;
+    };
+
+    void reset_buffers();
+    void configure_instance_attributes();
+    void write_buffer(GLenum target, Buffer& buffer, std::span<const std::byte> data, GLenum usage);
+    void write_stream(std::span<const std::byte> indices, std::span<const std::byte> vertices);
+    void count_allocation();
+
+    // What every indexed draw of the current contents needs
+    struct DrawParameters
+    {
+      GLenum mode;
+      GLenum index_type;
+      size_t index_size;   // In bytes
+      size_t index_offset; // In bytes, to the segment written last if streaming
+      GLint  base_vertex;
+    };
+    DrawParameters draw_parameters() const;
+    size_t vertex_buffer_bytes() const; // Index and vertex buffers, all segments included
+
+  private:
+    IndexType              m_index_type;
+    PrimitiveType          m_primitive_type;
+    size_t                 m_stride;
+    std::vector<Attribute> m_attributes;
+    size_t                 m_element_count;
 
     GLuint m_vao;
-    GLuint m_ebo;
-    GLuint m_vbo;
+    Buffer m_ebo;
+    Buffer m_vbo;
+    Buffer m_ibo; // Instances
+
+    size_t                 m_instance_stride;
+    std::vector<Attribute> m_instance_attributes;
+
+    bool   m_streaming;
+    size_t m_segment;
+    GLsync m_fences[STREAM_SEGMENT_COUNT];
+
+    Stats m_stats;
   };
 }
 
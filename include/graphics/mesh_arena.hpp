@@ -0,0 +1,87 @@
+#ifndef MESH_ARENA_HPP
+#define MESH_ARENA_HPP
+
+#include <graphics/mesh.hpp>
+
+#include <free_list_allocator.hpp>
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <span>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace graphics
+{
+  // Layout expected by GL in GL_DRAW_INDIRECT_BUFFER
+  struct DrawElementsIndirectCommand
+  {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint  base_vertex;
+    GLuint base_instance;
+  };
+
+  // Indices for drawing quad_count quads, each made of 4 consecutive vertices
+  // in the order bottom-left, bottom-right, top-left, top-right
+  std::vector<uint32_t> quad_indices(size_t quad_count);
+
+  /*
+   * Many triangle meshes sharing a single vertex array and vertex buffer, so
+   * that all of them can be drawn with one call to
+   * glMultiDrawElementsIndirect. Space in the vertex buffer is handed out by
+   * FreeListAllocator, and the buffer is only ever reallocated when it needs
+   * to grow.
+   *
+   * All meshes also share one static index buffer, with indices relative to
+   * the first vertex of each mesh, which is passed as base_vertex when
+   * drawing. This suits meshes that all have the same topology, such as
+   * quads, since only vertex data ever has to be uploaded per mesh.
+   */
+  class MeshArena
+  {
+  public:
+    struct Allocation
+    {
+      size_t vertex_offset;
+      size_t vertex_count;
+    };
+
+  public:
+    MeshArena(size_t stride, std::span<const Attribute> attributes, size_t vertex_capacity);
+    ~MeshArena();
+
+  public:
+    void set_indices(std::span<const uint32_t> indices);
+    size_t index_count() const { return m_index_count; }
+
+    Allocation allocate(std::span<const std::byte> vertices);
+    void free(const Allocation& allocation);
+
+    void draw(std::span<const DrawElementsIndirectCommand> commands);
+
+  public:
+    const FreeListAllocator& vertex_allocator() const { return m_vertex_allocator; }
+
+  private:
+    static void grow_buffer(GLuint& buffer, size_t old_size, size_t new_size);
+    void bind_buffers();
+
+  private:
+    size_t                 m_stride;
+    std::vector<Attribute> m_attributes;
+
+    FreeListAllocator m_vertex_allocator;
+    size_t            m_index_count;
+
+    GLuint m_vao;
+    GLuint m_vbo;
+    GLuint m_ebo;
+    GLuint m_dbo;
+  };
+}
+
+#endif // MESH_ARENA_HPP
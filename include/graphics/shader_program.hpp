@@ -4,6 +4,10 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <unordered_map>
+#include <string>
+#include <string_view>
+
 namespace graphics
 {
   class ShaderProgram
@@ -16,18 +20,36 @@ namespace graphics
     void use() const;
 
   public:
-    void set_uniform(const char* name, float value);
+    // Locations of all active uniforms are queried once after linking, so
+    // this never calls into the driver. Returns -1 for unknown names, which
+    // GL silently ignores, just like for uniforms optimized away.
+    GLint uniform_location(std::string_view name) const;
+
+  public:
+    void set_uniform(GLint location, int   value);
+    void set_uniform(GLint location, float value);
 
-    void set_uniform(const char* name, glm::vec2 value);
-    void set_uniform(const char* name, glm::vec3 value);
-    void set_uniform(const char* name, glm::vec4 value);
+    void set_uniform(GLint location, glm::vec2 value);
+    void set_uniform(GLint location, glm::vec3 value);
+    void set_uniform(GLint location, glm::vec4 value);
 
-    void set_uniform(const char* name, glm::mat2 value);
-    void set_uniform(const char* name, glm::mat3 value);
-    void set_uniform(const char* name, glm::mat4 value);
+    void set_uniform(GLint location, glm::mat2 value);
+    void set_uniform(GLint location, glm::mat3 value);
+    void set_uniform(GLint location, glm::mat4 value);
+
+    template<typename T>
+    void set_uniform(const char* name, T value) { set_uniform(uniform_location(name), value); }
+
+  private:
+    struct StringHash
+    {
+      using is_transparent = void;
+      size_t operator()(std::string_view str) const { return std::hash<std::string_view>{}(str); }
+    };
 
   private:
     GLuint m_id;
+    std::unordered_map<std::string, GLint, StringHash, std::equal_to<>> m_uniform_locations;
   };
 }
 
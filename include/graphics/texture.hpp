@@ -22,6 +22,7 @@ namespace graphics
 
   private:
     GLuint m_id;
+    size_t m_size; // In bytes, as uploaded
   };
 }
 
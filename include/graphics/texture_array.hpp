@@ -6,12 +6,45 @@
 #include <vector>
 #include <string>
 
+#include <cstdint>
+
 namespace graphics
 {
+  /*
+   * RGBA texels of every layer of a texture array, with the whole mip chain.
+   * Levels are stored one after the other, each holding all of its layers.
+   */
+  struct TextureArrayData
+  {
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t depth;
+    std::uint32_t level_count;
+
+    std::vector<unsigned char> bytes;
+
+    std::uint32_t level_width (std::uint32_t level) const { return width  >> level ? width  >> level : 1; }
+    std::uint32_t level_height(std::uint32_t level) const { return height >> level ? height >> level : 1; }
+    size_t        level_size  (std::uint32_t level) const { return size_t(level_width(level)) * level_height(level) * depth * 4; }
+  };
+
+  // Decode every image on the thread pool, in parallel, and compute the mip
+  // chain. Layer i is always filenames[i].
+  TextureArrayData decode_texture_array(const std::vector<std::string>& filenames);
+
+  // Same as decode_texture_array(), but go through a cache of cooked arrays
+  // in TEXTURE_ARRAY_CACHE_DIRECTORY, which is keyed on the filenames and on
+  // the size and modification time of every file. Nothing is decoded at all
+  // when the cache is up to date.
+  TextureArrayData load_texture_array(const std::vector<std::string>& filenames);
+
+  static constexpr const char *TEXTURE_ARRAY_CACHE_DIRECTORY = ".cache/textures";
+
   struct TextureArray
   {
     public:
-      TextureArray(const std::vector<std::string>& filenames);
+      TextureArray(const std::vector<std::string>& filenames, bool use_cache = true);
+      TextureArray(const TextureArrayData& data);
       ~TextureArray();
 
     public:
@@ -19,6 +52,7 @@ namespace graphics
 
     private:
       GLuint m_id;
+      size_t m_size; // In bytes, every level included
   };
 }
 
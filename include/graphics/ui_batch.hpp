@@ -0,0 +1,75 @@
+#ifndef UI_BATCH_HPP
+#define UI_BATCH_HPP
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <span>
+#include <string_view>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace graphics
+{
+  struct Texture;
+
+  // Placement of a glyph in a font atlas, in pixels except for the texture
+  // coordinates
+  struct Glyph
+  {
+    glm::vec2 dimension;
+    glm::vec2 bearing;
+    glm::vec2 advance;
+
+    glm::vec2 texture_min;
+    glm::vec2 texture_max;
+  };
+
+  /*
+   * CPU side of UIRenderer. Quads are accumulated in a single vertex and index
+   * buffer, and consecutive quads using the same texture are merged into one
+   * run, which is drawn with a single call when the batch is flushed.
+   *
+   * This never touches GL, textures are only compared by address.
+   */
+  class UIBatch
+  {
+  public:
+    struct Vertex
+    {
+      glm::vec2 position;
+      glm::vec2 tex_coords;
+    };
+
+    struct Run
+    {
+      const Texture *texture;
+      size_t         first_index;
+      size_t         index_count;
+    };
+
+  public:
+    void push_quad(const Texture& texture, glm::vec2 position, glm::vec2 dimension, glm::vec2 texture_min, glm::vec2 texture_max);
+
+    // Lay out a line of text starting at position, which is on the baseline.
+    // Glyphs are indexed by character, and str must only contain characters
+    // that have one.
+    void push_text(std::span<const Glyph> glyphs, const Texture& atlas, glm::vec2 position, std::string_view str);
+
+    void clear();
+    bool empty() const { return m_runs.empty(); }
+
+  public:
+    const std::vector<Vertex>&   vertices() const { return m_vertices; }
+    const std::vector<uint32_t>& indices()  const { return m_indices; }
+    const std::vector<Run>&      runs()     const { return m_runs; }
+
+  private:
+    std::vector<Vertex>   m_vertices;
+    std::vector<uint32_t> m_indices;
+    std::vector<Run>      m_runs;
+  };
+}
+
+#endif // UI_BATCH_HPP
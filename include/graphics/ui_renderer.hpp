@@ -3,21 +3,32 @@
 #include <graphics/shader_program.hpp>
 #include <graphics/mesh.hpp>
 #include <graphics/texture.hpp>
+#include <graphics/ui_batch.hpp>
 
 #include <memory>
 
 namespace graphics
 {
+  /*
+   * Everything rendered through here is only queued, and drawn on top of the
+   * scene by flush(), usually once at the end of the frame. Quads sharing a
+   * texture, such as all the text in one font, are drawn with a single call.
+   */
   class UIRenderer
   {
   public:
     UIRenderer();
 
   public:
-    void render(glm::vec2 viewport, glm::vec2 position, glm::vec2 dimension, const graphics::Texture& texture);
+    void render(glm::vec2 position, glm::vec2 dimension, const graphics::Texture& texture);
+    void flush(glm::vec2 viewport);
+
+    UIBatch& batch() { return m_batch; }
 
   private:
     std::unique_ptr<graphics::ShaderProgram> m_shader_program;
-    std::unique_ptr<graphics::Mesh>          m_quad_mesh;
+    std::unique_ptr<graphics::Mesh>          m_batch_mesh;
+
+    UIBatch m_batch;
   };
 }
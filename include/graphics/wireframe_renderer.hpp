@@ -1,23 +1,40 @@
 #pragma once
 
-#include <graphics/camera.hpp>
 #include <graphics/mesh.hpp>
 #include <graphics/shader_program.hpp>
 
 #include <memory>
+#include <vector>
 
 namespace graphics
 {
+  /*
+   * Cubes are only queued by render_cube(), and all drawn by flush() as one
+   * instanced draw per distinct line thickness, since the line width can not
+   * vary within a draw.
+   */
   class WireframeRenderer
   {
   public:
     WireframeRenderer();
 
   public:
-    void render_cube(const Camera& camera, glm::vec3 position, glm::vec3 dimension, glm::vec3 color, float thickness);
+    void render_cube(glm::vec3 position, glm::vec3 dimension, glm::vec3 color, float thickness);
+    void flush();
+
+  private:
+    struct Instance
+    {
+      glm::vec3 position;
+      glm::vec3 dimension;
+      glm::vec3 color;
+      float     thickness;
+    };
 
   private:
     std::unique_ptr<ShaderProgram> m_shader_program;
     std::unique_ptr<Mesh>          m_cube_mesh;
+
+    std::vector<Instance> m_instances;
   };
 }
@@ -14,12 +14,16 @@ private:
 
 public:
   template<typename F>
-  Lazy(F f) requires std::is_invocable_r_v<T, F>
+  Lazy(F f) requires std::is_invocable_r_v<T, F> : Lazy(TaskKind::GENERIC, std::move(f)) {}
+
+  template<typename F>
+  Lazy(TaskKind kind, F f) requires std::is_invocable_r_v<T, F>
   {
     m_state = std::make_shared<State>();
-    ThreadPool::instance().enqueue([state=m_state, f=std::move(f)](){
+    ThreadPool::instance().enqueue(kind, [state=m_state, f=std::move(f)](){
       ::new(&state->storage) T(f());
       state->done.store(true, std::memory_order_release);
+      state->done.notify_all();
     });
   }
 
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+/*
+ * Central place where subsystems report how much memory they hold, as a byte
+ * count and an object count per named gauge. Gauges are plain atomics, so
+ * they can be updated from any thread, usually by whoever owns the memory
+ * right where it is allocated or freed.
+ *
+ * Byte counts are what the subsystem knows about, such as element counts
+ * times element sizes or GPU buffer capacities, and leave out allocator and
+ * container overhead.
+ */
+class MemoryRegistry
+{
+public:
+  class Gauge
+  {
+  public:
+    void set(std::int64_t bytes, std::int64_t count)
+    {
+      m_bytes.store(bytes, std::memory_order_relaxed);
+      m_count.store(count, std::memory_order_relaxed);
+    }
+
+    void add(std::int64_t bytes, std::int64_t count = 0)
+    {
+      m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+      m_count.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    std::int64_t bytes() const { return m_bytes.load(std::memory_order_relaxed); }
+    std::int64_t count() const { return m_count.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<std::int64_t> m_bytes = 0;
+    std::atomic<std::int64_t> m_count = 0;
+  };
+
+  struct Entry
+  {
+    std::string  name;
+    std::int64_t bytes;
+    std::int64_t count;
+  };
+
+public:
+  static MemoryRegistry& instance();
+
+public:
+  // Created on first use. The reference stays valid forever, so callers
+  // should look it up once and keep it.
+  Gauge& gauge(const std::string& name);
+
+  // Sorted by name
+  std::vector<Entry> entries() const;
+
+  // Append a single line of JSON with every gauge, for soak tests
+  void dump_json_line(std::ostream& os, double time) const;
+
+private:
+  mutable std::mutex                            m_mutex;
+  std::map<std::string, std::unique_ptr<Gauge>> m_gauges;
+};
@@ -1,8 +1,7 @@
 #pragma once
 
-#include <graphics/camera.hpp>
 #include <graphics/wireframe_renderer.hpp>
 
-#include <world.hpp>
+#include <render_snapshot.hpp>
 
-void render_player_ui(const graphics::Camera& camera, const World& world, graphics::WireframeRenderer& wireframe_renderer);
+void render_player_ui(const RenderSnapshot& snapshot, graphics::WireframeRenderer& wireframe_renderer);
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <ostream>
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Scoped-zone profiler. Every thread records the zones it leaves into its own
+ * ring buffer, so recording never contends with other threads. Once per
+ * frame, end_frame() drains the rings into per-zone totals, which are turned
+ * into averages every AVERAGE_INTERVAL seconds for the debug overlay. The
+ * rings also keep the last RING_CAPACITY zones of each thread around, for
+ * dump_chrome_trace().
+ *
+ * Zone names must be string literals, or at least outlive the profiler,
+ * since only the pointer is stored. Zones are aggregated by name.
+ */
+class Profiler
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t RING_CAPACITY    = 1 << 14; // Zones, per thread
+  static constexpr float  AVERAGE_INTERVAL = 1.0f;    // In seconds
+
+  struct Zone
+  {
+    const char        *name;
+    Clock::time_point  begin;
+    Clock::time_point  end;
+  };
+
+  struct ZoneAverage
+  {
+    const char *name;
+    float       average_us;
+    float       max_us;
+    float       count_per_second;
+  };
+
+public:
+  static Profiler& instance();
+  Profiler();
+
+public:
+  void record(const char *name, Clock::time_point begin, Clock::time_point end);
+
+  void end_frame();
+  const std::vector<ZoneAverage>& averages() const { return m_averages; }
+
+  // Zones still in the rings, in the Trace Event Format understood by
+  // chrome://tracing and Perfetto
+  void dump_chrome_trace(std::ostream& os) const;
+
+private:
+  struct ThreadRing
+  {
+    std::mutex        mutex; // Only ever contended while draining or dumping
+    size_t            thread_index;
+    std::vector<Zone> zones;
+    std::uint64_t     head;    // Number of zones ever recorded
+    std::uint64_t     drained; // Number of zones already counted by end_frame()
+  };
+
+  struct ZoneTotal
+  {
+    const char    *name;
+    std::uint64_t  count;
+    Clock::duration total;
+    Clock::duration max;
+  };
+
+private:
+  ThreadRing& thread_ring();
+
+private:
+  mutable std::mutex                       m_mutex;
+  std::vector<std::unique_ptr<ThreadRing>> m_rings;
+  Clock::time_point                        m_start_time;
+
+  // Only touched by end_frame()
+  std::vector<ZoneTotal>   m_totals;
+  Clock::time_point        m_totals_time;
+  std::vector<ZoneAverage> m_averages;
+};
+
+class ProfileZone
+{
+public:
+  explicit ProfileZone(const char *name) : m_name(name), m_begin(Profiler::Clock::now()) {}
+  ~ProfileZone() { Profiler::instance().record(m_name, m_begin, Profiler::Clock::now()); }
+
+  ProfileZone(const ProfileZone&) = delete;
+  ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+  const char                 *m_name;
+  Profiler::Clock::time_point m_begin;
+};
+
+#define PROFILE_ZONE_CONCAT_(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_(a, b)
+
+// Profile the rest of the enclosing scope
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_CONCAT(profile_zone_, __LINE__)(name)
@@ -4,6 +4,15 @@
 
 #include <glm/glm.hpp>
 
+#include <span>
+
+struct Ray
+{
+  glm::vec3 position;
+  glm::vec3 direction;
+  float     length;
+};
+
 struct RayCastBlocksResult
 {
   enum class Type { INSIDE_BLOCK, HIT, NONE } type;
@@ -11,3 +20,8 @@ struct RayCastBlocksResult
   glm::ivec3 normal;
 };
 RayCastBlocksResult ray_cast_blocks(const World& world, glm::vec3 position, glm::vec3 direction, float length);
+
+// Cast a batch of rays, writing the result of rays[i] into results[i]. The
+// chunk being traversed is cached across steps and across rays, so this is
+// much cheaper than casting each ray on its own when rays are close together.
+void ray_cast_blocks(const World& world, std::span<const Ray> rays, std::span<RayCastBlocksResult> results);
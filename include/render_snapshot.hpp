@@ -0,0 +1,54 @@
+#pragma once
+
+#include <world.hpp>
+#include <entities.hpp>
+#include <transform.hpp>
+#include <aabb.hpp>
+
+#include <glm/glm.hpp>
+
+#include <optional>
+#include <vector>
+
+#include <cstdint>
+
+/*
+ * Everything the renderer needs to know about the simulation at the end of a
+ * tick, copied out of the World so that it can be read by the render thread
+ * while the next tick is already running. Chunks are not part of it, see
+ * Simulation::world_mutex().
+ */
+struct RenderSnapshot
+{
+  struct Entity
+  {
+    EntityHandle  handle;
+    std::uint16_t id;
+    Transform     transform;
+    AABB          aabb;
+    float         eye;
+  };
+
+  std::uint64_t       tick;
+  std::vector<Entity> entities;
+  size_t              player_index; // Into entities
+
+  // Only shown by the debug overlay, never interpolated
+  glm::vec3            player_velocity;
+  bool                 player_collided;
+  bool                 player_grounded;
+  bool                 player_sleeping;
+  std::optional<Block> player_block;
+
+  std::optional<glm::ivec3> selection;
+  std::optional<glm::ivec3> placement;
+
+  const Entity& player() const { return entities[player_index]; }
+};
+
+RenderSnapshot make_render_snapshot(const World& world, std::uint64_t tick);
+
+// Blend entity transforms from previous to current, with alpha in [0, 1].
+// Entities are matched by handle, and those that did not exist yet in
+// previous are taken as is from current. Everything else comes from current.
+RenderSnapshot interpolate_render_snapshots(const RenderSnapshot& previous, const RenderSnapshot& current, float alpha);
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <world.hpp>
+
+#include <glm/glm.hpp>
+
+#include <functional>
+
+#include <cstdint>
+
+/*
+ * Which faces of a chunk section can be seen from which other faces, through
+ * connected empty blocks inside the section. Faces are indexed in the same
+ * order as DIRECTIONS.
+ *
+ * This is what lets us skip cave sections when standing on the surface: the
+ * only way to see into a cave is through a chain of sections connected face
+ * to face, and most caves do not open up to the surface.
+ */
+class SectionVisibility
+{
+public:
+  static constexpr int FACE_COUNT = 6;
+
+public:
+  SectionVisibility() : m_bits(0) {}
+  static SectionVisibility all();
+
+public:
+  void connect(int face1, int face2);
+  bool connected(int face1, int face2) const;
+
+private:
+  std::uint64_t m_bits; // Bit face1 * FACE_COUNT + face2
+};
+
+SectionVisibility compute_section_visibility(const Chunk& chunk, int section);
+
+/*
+ * Breadth-first traversal of the sections that can be seen from the start
+ * section, with sections addressed as (chunk_index.x, chunk_index.y, section).
+ * We only ever step from a section into a neighbour if
+ *  - the face we step out of is visible from the face we entered through,
+ *  - we have not yet stepped in the opposite direction on the way here, and
+ *  - the neighbour is in the view frustum.
+ *
+ * get_visibility returns nullptr for sections that are not available, which
+ * are treated as opaque. visit is called once for every section reached,
+ * including the start section.
+ */
+void traverse_visible_sections(
+  glm::ivec3 start,
+  const std::function<const SectionVisibility*(glm::ivec3)>& get_visibility,
+  const std::function<bool(glm::ivec3)>&                     in_frustum,
+  const std::function<void(glm::ivec3)>&                     visit
+);
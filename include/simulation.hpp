@@ -0,0 +1,94 @@
+#pragma once
+
+#include <world.hpp>
+#include <world_generator.hpp>
+#include <light_manager.hpp>
+#include <render_snapshot.hpp>
+#include <timer.hpp>
+
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <memory>
+
+#include <cstdint>
+
+// State of the controls, sampled by the render thread every frame
+struct PlayerInput
+{
+  bool key_space;
+  bool key_w;
+  bool key_a;
+  bool key_s;
+  bool key_d;
+
+  bool mouse_button_left;
+  bool mouse_button_right;
+
+  double cursor_motion_x;
+  double cursor_motion_y;
+};
+
+/*
+ * Runs the fixed-step simulation on its own thread, so that a slow tick never
+ * delays a frame. Every tick publishes an immutable RenderSnapshot, and the
+ * render thread draws a blend of the last two, one tick in the past.
+ */
+class Simulation
+{
+public:
+  using Clock = Timer::Clock;
+
+  static constexpr float FIXED_DT = 1.0f / 20.0f;
+
+  // Ticks run late beyond this many are dropped rather than caught up on
+  static constexpr size_t MAX_CATCH_UP_TICKS = 5;
+
+  struct Snapshots
+  {
+    std::shared_ptr<const RenderSnapshot> previous;
+    std::shared_ptr<const RenderSnapshot> current;
+    Clock::time_point                     current_time; // When the tick of current was due
+
+    Timer::Stats tick_stats;
+
+    // How far the render thread is from previous to current at time now
+    float alpha(Clock::time_point now) const;
+  };
+
+public:
+  Simulation(World& world, WorldGenerator& world_generator, LightManager& light_manager);
+
+public:
+  // Keys and buttons are taken as they are at the next tick, while cursor
+  // motion accumulates until a tick consumes it
+  void push_input(const PlayerInput& input);
+  Snapshots snapshots() const;
+
+  // Held for the whole of every tick. Anything else reading the world, such
+  // as copying chunks out for meshing, must hold it too, and should try_lock
+  // it so as not to wait for a tick to finish. It should also do as little as
+  // it can while holding it, since ticks wait for it.
+  std::mutex& world_mutex() { return m_world_mutex; }
+
+private:
+  void run(std::stop_token stoken);
+  std::shared_ptr<const RenderSnapshot> tick();
+
+private:
+  World&          m_world;
+  WorldGenerator& m_world_generator;
+  LightManager&   m_light_manager;
+  std::mutex      m_world_mutex;
+
+  mutable std::mutex m_input_mutex;
+  PlayerInput        m_input;
+
+  mutable std::mutex m_snapshots_mutex;
+  Snapshots          m_snapshots;
+  std::uint64_t      m_tick;
+  Timer              m_timer; // Only used by the simulation thread
+
+  // Last, so that the thread is stopped before anything it uses is destroyed
+  std::jthread m_thread;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <aabb.hpp>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+
+#include <unordered_map>
+#include <vector>
+#include <span>
+#include <utility>
+
+#include <cstdint>
+
+/*
+ * Uniform grid over entity bounding boxes. Every entity is inserted into all
+ * cells its AABB touches, and queries only visit the cells they overlap.
+ *
+ * Results are reported exactly once. An entity, or pair of entities, is only
+ * reported from the first cell of the region shared by everything involved,
+ * so we do not need a visited set to deduplicate.
+ */
+class SpatialHash
+{
+public:
+  static constexpr float CELL_SIZE = 4.0f;
+
+public:
+  void rebuild(std::span<const AABB> aabbs);
+  size_t size() const { return m_aabbs.size(); }
+
+public:
+  void query_aabb(const AABB& aabb, std::vector<std::uint32_t>& result) const;
+  void query_radius(glm::vec3 center, float radius, std::vector<std::uint32_t>& result) const;
+
+  // Pairs are sorted, with first < second in each pair.
+  void query_pairs(std::vector<std::pair<std::uint32_t, std::uint32_t>>& result) const;
+
+private:
+  static glm::ivec3 cell_min(const AABB& aabb);
+  static glm::ivec3 cell_max(const AABB& aabb);
+
+private:
+  std::vector<AABB>                                          m_aabbs;
+  std::unordered_map<glm::ivec3, std::vector<std::uint32_t>> m_cells;
+};
@@ -4,23 +4,135 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <memory>
 
 #include <vector>
 #include <deque>
+#include <string>
+#include <ostream>
+
+#include <cstdint>
+
+enum class TaskKind {
+  GENERIC,
+  CHUNK_INFO,
+  FAR_TERRAIN,
+  CHUNK_MESH,
+  ASSET_DECODE,
+  COUNT,
+};
+
+const char *task_kind_name(TaskKind kind);
 
 class ThreadPool
 {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Bucket i counts durations in [2^(i-1), 2^i) microseconds, with bucket 0
+  // for anything below 1us and the last bucket for everything too long.
+  static constexpr size_t HISTOGRAM_BUCKET_COUNT = 24;
+
+  struct Histogram
+  {
+    std::uint64_t count;
+    std::uint64_t total_us;
+    std::uint64_t buckets[HISTOGRAM_BUCKET_COUNT];
+
+    float average_us() const;
+    float percentile_us(float percentile) const;
+  };
+
+  struct KindStats
+  {
+    std::uint64_t enqueued;
+    std::uint64_t started;
+    std::uint64_t completed;
+    std::uint64_t pending;   // Queued, but not started yet
+
+    Histogram wait_time;
+    Histogram run_time;
+  };
+
+  struct WorkerStats
+  {
+    std::uint64_t busy_ns;
+    std::uint64_t uptime_ns;
+  };
+
+  struct Stats
+  {
+    size_t                   queue_depth;
+    KindStats                kinds[static_cast<size_t>(TaskKind::COUNT)];
+    std::vector<WorkerStats> workers;
+
+    // Fraction of time each worker spent running tasks since an earlier
+    // snapshot, or since the pool was created if there is none.
+    std::vector<float> utilisations(const Stats *previous = nullptr) const;
+
+    void dump_json(std::ostream& os) const;
+  };
+
 public:
   static ThreadPool& instance();
   ThreadPool();
+  ~ThreadPool();
 
 public:
   void enqueue(std::function<void()> task);
+  void enqueue(TaskKind kind, std::function<void()> task);
+
+public:
+  size_t queue_depth() const;
+  Stats stats() const;
 
 private:
-  std::mutex                        m_mutex;
-  std::condition_variable_any       m_cv;
-  std::deque<std::function<void()>> m_tasks;
+  struct Task
+  {
+    TaskKind              kind;
+    Clock::time_point     enqueued_at;
+    std::function<void()> function;
+  };
+
+  // Only ever written by its own worker thread, so that recording a task
+  // never contends with other workers. Readers take relaxed snapshots.
+  struct alignas(64) WorkerState
+  {
+    struct AtomicHistogram
+    {
+      std::atomic<std::uint64_t> count;
+      std::atomic<std::uint64_t> total_us;
+      std::atomic<std::uint64_t> buckets[HISTOGRAM_BUCKET_COUNT];
+
+      void record(Clock::duration duration);
+      void accumulate(Histogram& histogram) const;
+    };
+
+    struct KindState
+    {
+      std::atomic<std::uint64_t> started;
+      std::atomic<std::uint64_t> completed;
+      AtomicHistogram            wait_time;
+      AtomicHistogram            run_time;
+    };
+
+    KindState                  kinds[static_cast<size_t>(TaskKind::COUNT)];
+    std::atomic<std::uint64_t> busy_ns;
+  };
+
+private:
+  void worker(std::stop_token stoken, WorkerState& state);
+
+private:
+  mutable std::mutex          m_mutex;
+  std::condition_variable_any m_cv;
+  std::deque<Task>            m_tasks;
+
+  std::uint64_t m_enqueued[static_cast<size_t>(TaskKind::COUNT)];
 
-  std::vector<std::jthread> m_threads;
+  Clock::time_point                         m_start_time;
+  std::vector<std::unique_ptr<WorkerState>> m_worker_states;
+  std::vector<std::jthread>                 m_threads;
 };
@@ -1,13 +1,61 @@
 #pragma once
 
+#include <chrono>
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Fixed-step scheduler. Steps are due every step duration from the start
+ * time, and poll() says how many are due, so that a caller that fell behind
+ * catches up by running several in a row. Catching up is bounded by
+ * max_catch_up, and steps beyond that are dropped instead, so that a long
+ * stall does not turn into a long burst of steps.
+ *
+ * Time is always passed in, so this works without GLFW or any window.
+ */
 class Timer
 {
 public:
-  Timer();
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t DEFAULT_MAX_CATCH_UP = 5;
+
+  struct Stats
+  {
+    std::uint64_t tick_count;
+    std::uint64_t dropped_tick_count;
+
+    Clock::duration last_tick_duration;
+    Clock::duration max_tick_duration;
+    Clock::duration total_tick_duration;
+
+    // How long after being due steps actually started
+    Clock::duration last_lateness;
+    Clock::duration max_lateness;
+  };
 
 public:
-  bool tick(float dt);
+  Timer(Clock::duration step, size_t max_catch_up = DEFAULT_MAX_CATCH_UP, Clock::time_point start = Clock::now());
+
+public:
+  // Number of steps due at time now, at most max_catch_up. Each one is
+  // expected to be followed by a call to record_tick().
+  size_t poll(Clock::time_point now);
+  void record_tick(Clock::duration duration);
+
+  // When the next step is due
+  Clock::time_point next_tick() const { return m_next_tick; }
+
+  // When the last step returned by poll() was due
+  Clock::time_point last_tick() const { return m_next_tick - m_step; }
+
+  Clock::duration step() const { return m_step; }
+  const Stats& stats() const { return m_stats; }
 
 private:
-  float m_previous_time;
+  Clock::duration   m_step;
+  size_t            m_max_catch_up;
+  Clock::time_point m_next_tick;
+  Stats             m_stats;
 };
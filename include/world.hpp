@@ -1,6 +1,9 @@
 #pragma once
 
 #include <transform.hpp>
+#include <aabb.hpp>
+#include <entities.hpp>
+#include <spatial_hash.hpp>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
@@ -15,32 +18,42 @@
 static constexpr int CHUNK_WIDTH  = 16;
 static constexpr int CHUNK_HEIGHT = 256;
 
-static constexpr std::uint32_t BLOCK_ID_STONE = 0;
-static constexpr std::uint32_t BLOCK_ID_GRASS = 1;
-static constexpr std::uint32_t BLOCK_ID_NONE  = 2;
+// Chunks are split vertically into sections of CHUNK_WIDTH^3 blocks, and
+// every section into 4x4x4 bricks of BRICK_WIDTH^3 blocks.
+static constexpr int CHUNK_SECTION_HEIGHT = CHUNK_WIDTH;
+static constexpr int CHUNK_SECTION_COUNT  = CHUNK_HEIGHT / CHUNK_SECTION_HEIGHT;
+static constexpr int BRICK_WIDTH          = 4;
 
-struct AABB
+// Chunks far away from the camera are drawn from downsampled copies of their
+// blocks. Level 0 is the blocks themselves, and every level after that halves
+// the resolution, so that a cell at level l covers 2^l blocks on a side.
+static constexpr int CHUNK_LOD_COUNT = 4;
+
+constexpr glm::ivec3 lod_dimension(int level)
 {
-  glm::vec3 position;
-  glm::vec3 dimension;
-};
+  return glm::ivec3(CHUNK_WIDTH >> level, CHUNK_WIDTH >> level, CHUNK_HEIGHT >> level);
+}
 
-struct Entity
+constexpr int lod_cell_count(int level)
 {
-  std::uint16_t id;
-  Transform     transform;
-  glm::vec3     velocity;
+  return (CHUNK_WIDTH >> level) * (CHUNK_WIDTH >> level) * (CHUNK_HEIGHT >> level);
+}
 
-  glm::vec3 dimension;
-  float     eye;
+// Offset of the first cell of a level in Chunk::lod_cells, which starts at level 1
+constexpr int lod_cell_offset(int level)
+{
+  return level <= 1 ? 0 : lod_cell_offset(level - 1) + lod_cell_count(level - 1);
+}
 
-  bool collided;
-  bool grounded;
-};
+static constexpr int CHUNK_LOD_CELL_COUNT = lod_cell_offset(CHUNK_LOD_COUNT);
+
+static constexpr std::uint32_t BLOCK_ID_STONE = 0;
+static constexpr std::uint32_t BLOCK_ID_GRASS = 1;
+static constexpr std::uint32_t BLOCK_ID_NONE  = 2;
 
 struct Player
 {
-  size_t entity_id;
+  EntityHandle entity;
 
   bool key_space : 1;
   bool key_w     : 1;
@@ -55,6 +68,11 @@ struct Player
   double cursor_motion_y;
 
   float cooldown;
+
+  // Block the player is looking at, and where a block would be placed. These
+  // are updated once per tick by update_player_control.
+  std::optional<glm::ivec3> selection;
+  std::optional<glm::ivec3> placement;
 };
 
 struct Block
@@ -69,24 +87,41 @@ struct Chunk
 {
   Block blocks[CHUNK_HEIGHT][CHUNK_WIDTH][CHUNK_WIDTH];
 
+  // One bit per brick in each section, set if any block in the brick is not
+  // BLOCK_ID_NONE, so a section is empty iff its mask is zero. This has to
+  // be kept in sync with blocks using update_occupancy().
+  std::uint64_t occupancy[CHUNK_SECTION_COUNT];
+
+  // Cells of LOD levels 1 to CHUNK_LOD_COUNT-1, one level after another.
+  // This has to be kept in sync with blocks using update_lod().
+  Block lod_cells[CHUNK_LOD_CELL_COUNT];
+
   mutable bool                           mesh_invalidated;
 };
 
 struct World
 {
   std::unordered_map<glm::ivec2, Chunk> chunks;
-  std::vector<Entity>                   entities;
+  Entities                              entities;
   std::vector<Player>                   players;
+
+  // Rebuilt from the entity bounding boxes at the end of every physics step
+  SpatialHash entity_hash;
 };
 
 /**********
  * Entity *
  **********/
-AABB entity_get_aabb(const Entity& entity);
+// These take dense indices into World::entities, see Entities::index()
+AABB entity_get_aabb(const Entities& entities, size_t index);
 
-void entity_apply_impulse (Entity& entity, glm::vec3 force);
-void entity_apply_force   (Entity& entity, glm::vec3 force, float dt);
-void entity_apply_force   (Entity& entity, glm::vec3 force, float dt, float max);
+std::vector<EntityHandle> query_entities(const World& world, const AABB& aabb);
+std::vector<EntityHandle> query_entities(const World& world, glm::vec3 center, float radius);
+
+void entity_wake          (Entities& entities, size_t index);
+void entity_apply_impulse (Entities& entities, size_t index, glm::vec3 force);
+void entity_apply_force   (Entities& entities, size_t index, glm::vec3 force, float dt);
+void entity_apply_force   (Entities& entities, size_t index, glm::vec3 force, float dt, float max);
 
 /******************
  * Block Accessor *
@@ -97,6 +132,32 @@ const Block* get_block(const Chunk& chunk, glm::ivec3 position);
       Block* get_block(      World& world, glm::ivec3 position);
 const Block* get_block(const World& world, glm::ivec3 position);
 
+/*************
+ * Occupancy *
+ *************/
+inline std::uint64_t brick_bit(glm::ivec3 position)
+{
+  glm::ivec3 brick = (position % CHUNK_SECTION_HEIGHT) / BRICK_WIDTH;
+  return std::uint64_t(1) << (brick.z * 16 + brick.y * 4 + brick.x);
+}
+
+void update_occupancy(Chunk& chunk);
+void update_occupancy(Chunk& chunk, glm::ivec3 position);
+void update_occupancy(World& world, glm::ivec3 position);
+
+/*******
+ * LOD *
+ *******/
+// Cell of a chunk at the given LOD level, or nullptr if out of range. A cell
+// is solid if at least half of the cells it was downsampled from are, and
+// takes the id of the topmost of them so that surfaces keep their look. Its
+// light level is the brightest of its empty cells.
+const Block* get_lod_block(const Chunk& chunk, int level, glm::ivec3 cell);
+
+void update_lod(Chunk& chunk);
+void update_lod(Chunk& chunk, glm::ivec3 position);
+void update_lod(World& world, glm::ivec3 position);
+
 /**************************
  * Invalidate them ALL!!! *
  **************************/
@@ -104,4 +165,7 @@ void invalidate_mesh (Chunk& chunk);
 
 void invalidate_mesh(World& world, glm::ivec3 position);
 
+// Wake up any entity that could be resting on or against the block at position
+void wake_entities(World& world, glm::ivec3 position);
+
 World load_world(std::string_view path);
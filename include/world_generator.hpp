@@ -46,15 +46,45 @@ struct WorldGenerationConfig
 
 WorldGenerationConfig load_world_generation_config(std::string_view path);
 
+/*
+ * Evaluates the terrain height maps at arbitrary positions without generating
+ * any chunk. The heights are the same as those of the chunks that eventually
+ * get generated there, only without the caves.
+ */
+class TerrainSampler
+{
+public:
+  struct Sample
+  {
+    float         height;   // Blocks below this height are solid
+    std::uint32_t block_id; // Id of the topmost block
+  };
+
+public:
+  TerrainSampler(std::size_t seed, TerrainGenerationConfig config);
+
+public:
+  Sample sample(glm::vec2 position) const;
+  float layer_height(size_t layer, glm::vec2 position) const;
+
+  size_t layer_count() const { return m_config.layers.size(); }
+
+private:
+  TerrainGenerationConfig  m_config;
+  std::vector<std::size_t> m_seeds;
+};
+
 class WorldGenerator
 {
 public:
-  static constexpr size_t CHUNK_LOAD_RADIUS = 4;
+  static constexpr size_t CHUNK_LOAD_RADIUS = 12;
 
 public:
   WorldGenerator(WorldGenerationConfig config);
 
 public:
+  const WorldGenerationConfig& config() const { return m_config; }
+
   void update(World& world, LightManager& light_manager);
 
 private:
@@ -63,6 +93,7 @@ private:
 
 private:
   WorldGenerationConfig m_config;
+  TerrainSampler        m_terrain_sampler;
 
 private:
   struct HeightMap
@@ -87,9 +118,9 @@ private:
   };
 
 private:
-  template<typename Prng> static std::vector<HeightMap> generate_height_maps(Prng& prng, const TerrainGenerationConfig& config, glm::ivec2 chunk_index);
+  static std::vector<HeightMap> generate_height_maps(const TerrainSampler& terrain_sampler, glm::ivec2 chunk_index);
   template<typename Prng> static std::vector<Worm> generate_worms(Prng& prng, const CavesGenerationConfig& config, glm::ivec2 chunk_index);
-  template<typename Prng> static ChunkInfo generate_chunk_info(Prng& prng_global, Prng& prng_local, const WorldGenerationConfig& config, glm::ivec2 chunk_index);
+  template<typename Prng> static ChunkInfo generate_chunk_info(Prng& prng, const TerrainSampler& terrain_sampler, const WorldGenerationConfig& config, glm::ivec2 chunk_index);
 
 private:
   std::unordered_map<glm::ivec2, Lazy<ChunkInfo>> m_chunk_infos;
@@ -1,11 +1,17 @@
 #pragma once
 
 #include <world.hpp>
+#include <render_snapshot.hpp>
 
+#include <far_terrain_renderer.hpp>
+
+#include <lazy.hpp>
 #include <resource_pack.hpp>
+#include <section_visibility.hpp>
 
 #include <graphics/camera.hpp>
 #include <graphics/mesh.hpp>
+#include <graphics/mesh_arena.hpp>
 #include <graphics/shader_program.hpp>
 #include <graphics/texture.hpp>
 #include <graphics/texture_array.hpp>
@@ -24,15 +30,64 @@ class WorldRenderer
 public:
   static constexpr double REMASH_THROTTLE = 5.0f;
 
+  // Initial size of the arena holding all chunk meshes, in vertices, and of
+  // the quad index buffer shared by all of them, in quads. This is enough for
+  // the chunks around the spawn point, and both grow if they run out.
+  static constexpr size_t CHUNK_ARENA_VERTEX_CAPACITY = 1 << 20;
+  static constexpr size_t CHUNK_ARENA_QUAD_CAPACITY   = 1 << 14;
+
+  // Chunks more than CHUNK_LOD_DISTANCES[l] chunks away from the camera are
+  // meshed at LOD level l+1. Every level has roughly a quarter of the faces
+  // of the previous one. With WorldGenerator::CHUNK_LOAD_RADIUS, this keeps
+  // the total vertex count about where it was for a radius of 4 chunks, all
+  // at full detail.
+  static constexpr int CHUNK_LOD_DISTANCES[CHUNK_LOD_COUNT - 1] = { 2, 4, 6 };
+
+  // Maximum number of chunks being remeshed at once. Starting a remesh copies
+  // the chunk and its neighbours out of the world, which is all the meshing
+  // done while holding the world lock, so this also bounds how long update()
+  // holds it for.
+  static constexpr size_t REMESH_BUDGET = 8;
+
+  // Statistics about the last call to render()
+  struct Stats
+  {
+    size_t chunk_count;
+    size_t chunk_pending_count; // Being remeshed
+    size_t chunk_culled_count;
+    size_t section_count;
+    size_t section_culled_count;
+    size_t section_occluded_count;
+    size_t draw_count;      // Number of indirect draw commands
+    size_t draw_call_count; // Number of actual GL draw calls
+
+    size_t entity_count;
+    size_t entity_draw_call_count;
+
+    size_t lod_chunk_counts[CHUNK_LOD_COUNT];
+    size_t lod_vertex_counts[CHUNK_LOD_COUNT];
+
+    FarTerrainRenderer::Stats far_terrain;
+  };
+
 public:
-  WorldRenderer(ResourcePack resource_pack);
+  WorldRenderer(ResourcePack resource_pack, const WorldGenerationConfig& world_generation_config);
+  ~WorldRenderer();
 
 public:
-  void render(const graphics::Camera& camera, const World& world, bool third_person, graphics::WireframeRenderer& wireframe_renderer);
+  // Start rebuilding the meshes of chunks that changed, from copies of them
+  // meshed on the thread pool. This is the only part that reads the world,
+  // and can be skipped on frames where it is busy. Meshes are swapped in by
+  // render() once they are done.
+  void update(const graphics::Camera& camera, const World& world);
+
+  void render(const graphics::Camera& camera, const RenderSnapshot& snapshot, bool third_person, graphics::WireframeRenderer& wireframe_renderer);
+  const Stats& stats() const { return m_stats; }
 
 private:
-  void render_chunks(const graphics::Camera& camera, const World& world);
-  void render_entites(const graphics::Camera& camera, const World& world, bool third_person, graphics::WireframeRenderer& wireframe_renderer);
+  void upload_chunk_meshes();
+  void render_chunks(const graphics::Camera& camera);
+  void render_entites(const graphics::Camera& camera, const RenderSnapshot& snapshot, bool third_person, graphics::WireframeRenderer& wireframe_renderer);
 
 private:
   ResourcePack m_resource_pack;
@@ -40,5 +95,45 @@ private:
   std::unique_ptr<graphics::ShaderProgram> m_chunk_shader_program;
   std::unique_ptr<graphics::ShaderProgram> m_entity_shader_program;
 
-  std::unordered_map<glm::ivec2, std::unique_ptr<graphics::Mesh>> m_chunk_meshes;
+  // Blocks are meshed one z-layer at a time, so the quads for each section of
+  // a chunk end up contiguous and can be drawn separately. Section index
+  // offsets are into the shared quad index buffer, which is drawn with the
+  // chunk's vertex offset as base vertex.
+  struct ChunkMesh
+  {
+    struct Section
+    {
+      size_t index_offset;
+      size_t index_count;
+    };
+
+    graphics::MeshArena::Allocation allocation;
+
+    // LOD of the mesh, and of its neighbours in the first four DIRECTIONS
+    // when it was built, since border faces depend on them
+    int lod;
+    int neighbour_lods[4];
+
+    Section                         sections[CHUNK_SECTION_COUNT];
+    SectionVisibility               visibilities[CHUNK_SECTION_COUNT];
+
+    // Bitmask of sections reached by the occlusion culling traversal this frame
+    std::uint32_t visible_sections;
+  };
+
+  // Output of meshing a chunk on the thread pool, defined along with the vertex format
+  struct ChunkMeshData;
+
+  std::unique_ptr<FarTerrainRenderer> m_far_terrain_renderer;
+
+  // Model matrices of the entities to draw this frame, by entity id, so that
+  // all entities sharing a mesh and texture are drawn with one instanced call
+  std::vector<std::vector<glm::mat4>> m_entity_instances;
+
+  std::unique_ptr<graphics::MeshArena>               m_chunk_arena;
+  std::unordered_map<glm::ivec2, ChunkMesh>          m_chunk_meshes;
+  std::unordered_map<glm::ivec2, std::unique_ptr<Lazy<ChunkMeshData>>> m_pending_chunk_meshes;
+  std::vector<graphics::DrawElementsIndirectCommand> m_draw_commands;
+
+  Stats m_stats;
 };
@@ -1,16 +1,20 @@
 #include <debug_renderer.hpp>
 
-#include <ray_cast.hpp>
+#include <graphics/mesh.hpp>
 
-#include <fmt/format.h>
+#include <profiler.hpp>
+#include <memory_registry.hpp>
 
-static constexpr float RAY_CAST_LENGTH = 20.0f;
+#include <fmt/format.h>
 
 DebugRenderer::DebugRenderer()
 {
   m_font = std::make_unique<graphics::Font>(DEBUG_FONT, DEBUG_FONT_HEIGHT);
   for(size_t i=0; i<DT_AVERAGE_COUNT; ++i)
     m_dts[i] = 0.0f;
+
+  m_thread_pool_stats      = ThreadPool::instance().stats();
+  m_thread_pool_stats_time = ThreadPool::Clock::now();
 }
 
 void DebugRenderer::update(float dt)
@@ -20,7 +24,7 @@ void DebugRenderer::update(float dt)
   m_dts[DT_AVERAGE_COUNT-1] = dt;
 }
 
-void DebugRenderer::render(glm::vec2 viewport, const World& world, graphics::UIRenderer& ui_renderer)
+void DebugRenderer::render(glm::vec2 viewport, const RenderSnapshot& snapshot, const Timer::Stats& tick_stats, const WorldRenderer::Stats& world_renderer_stats, graphics::UIRenderer& ui_renderer)
 {
   // 1: Frame time
   float average = 0.0f;
@@ -29,58 +33,119 @@ void DebugRenderer::render(glm::vec2 viewport, const World& world, graphics::UIR
   average /= DT_AVERAGE_COUNT;
 
   // 2: Current block
-  const Player& player        = world.players.front();
-  const Entity& player_entity = world.entities.at(player.entity_id);
-  glm::ivec3   position = glm::floor(player_entity.transform.position);
-  const Block* block    = get_block(world, position);
-
-  // 3: Raycast
-  RayCastBlocksResult ray_cast_result = ray_cast_blocks(world, player_entity.transform.position + glm::vec3(0.0f, 0.0f, player_entity.eye), player_entity.transform.local_forward(), RAY_CAST_LENGTH);
-
-  std::optional<glm::ivec3> selection, placement;
-  switch(ray_cast_result.type)
-  {
-    case RayCastBlocksResult::Type::INSIDE_BLOCK:
-      selection = ray_cast_result.position;
-      placement = std::nullopt;
-      break;
-    case RayCastBlocksResult::Type::HIT:
-      selection = ray_cast_result.position;
-      placement = ray_cast_result.position + ray_cast_result.normal;
-      break;
-    case RayCastBlocksResult::Type::NONE:
-      selection = std::nullopt;
-      placement = std::nullopt;
-      break;
-  }
-
+  Transform                   transform = snapshot.player().transform;
+  glm::vec3                   velocity  = snapshot.player_velocity;
+  glm::ivec3                  position  = glm::floor(transform.position);
+  const std::optional<Block>& block     = snapshot.player_block;
 
   size_t n = 0;
 
-  render_line(viewport, n++, fmt::format("position: x = {}, y = {}, z = {}", player_entity.transform.position.x, player_entity.transform.position.y, player_entity.transform.position.z), ui_renderer);
-  render_line(viewport, n++, fmt::format("velocity: x = {}, y = {}, z = {}", player_entity.velocity.x, player_entity.velocity.y, player_entity.velocity.z), ui_renderer);
-  render_line(viewport, n++, fmt::format("collided = {}", player_entity.collided), ui_renderer);
-  render_line(viewport, n++, fmt::format("grounded = {}", player_entity.grounded), ui_renderer);
-  render_line(viewport, n++, fmt::format("average update time = {}", average), ui_renderer);
+  render_line(n++, fmt::format("position: x = {}, y = {}, z = {}", transform.position.x, transform.position.y, transform.position.z), ui_renderer);
+  render_line(n++, fmt::format("velocity: x = {}, y = {}, z = {}", velocity.x, velocity.y, velocity.z), ui_renderer);
+  render_line(n++, fmt::format("collided = {}", snapshot.player_collided), ui_renderer);
+  render_line(n++, fmt::format("grounded = {}", snapshot.player_grounded), ui_renderer);
+  render_line(n++, fmt::format("sleeping = {}", snapshot.player_sleeping), ui_renderer);
+  render_line(n++, fmt::format("average frame time = {:.2f}ms", average * 1000.0f), ui_renderer);
+
+  using Milliseconds = std::chrono::duration<float, std::milli>;
+  render_line(n++, fmt::format("ticks: {} run, {} dropped, duration = {:.2f}ms (max {:.2f}ms), lateness = {:.2f}ms (max {:.2f}ms)",
+    tick_stats.tick_count, tick_stats.dropped_tick_count,
+    Milliseconds(tick_stats.last_tick_duration).count(), Milliseconds(tick_stats.max_tick_duration).count(),
+    Milliseconds(tick_stats.last_lateness)     .count(), Milliseconds(tick_stats.max_lateness)     .count()), ui_renderer);
 
   if(block)
-    render_line(viewport, n++, fmt::format("block: position = {}, {}, {}, id = {}, sky = {}, light level = {}", position.x, position.y, position.z, block->id, block->sky, block->light_level), ui_renderer);
+    render_line(n++, fmt::format("block: position = {}, {}, {}, id = {}, sky = {}, light level = {}", position.x, position.y, position.z, block->id, block->sky, block->light_level), ui_renderer);
   else
-    render_line(viewport, n++, fmt::format("block: position = {}, {}, {}, not yet generated", position.x, position.y, position.z), ui_renderer);
+    render_line(n++, fmt::format("block: position = {}, {}, {}, not yet generated", position.x, position.y, position.z), ui_renderer);
 
-  if(selection)
-    render_line(viewport, n++, fmt::format("selection: position = {}, {}, {}", selection->x, selection->y, selection->z), ui_renderer);
+  if(snapshot.selection)
+    render_line(n++, fmt::format("selection: position = {}, {}, {}", snapshot.selection->x, snapshot.selection->y, snapshot.selection->z), ui_renderer);
   else
-    render_line(viewport, n++, "selection: none", ui_renderer);
+    render_line(n++, "selection: none", ui_renderer);
 
-  if(placement)
-    render_line(viewport, n++, fmt::format("placement: position = {}, {}, {}", placement->x, placement->y, placement->z), ui_renderer);
+  if(snapshot.placement)
+    render_line(n++, fmt::format("placement: position = {}, {}, {}", snapshot.placement->x, snapshot.placement->y, snapshot.placement->z), ui_renderer);
   else
-    render_line(viewport, n++, "placement: none", ui_renderer);
+    render_line(n++, "placement: none", ui_renderer);
+
+  render_line(n++, fmt::format("chunks: {} culled / {} total, {} remeshing", world_renderer_stats.chunk_culled_count, world_renderer_stats.chunk_count, world_renderer_stats.chunk_pending_count), ui_renderer);
+  render_line(n++, fmt::format("sections: {} culled / {} occluded / {} total", world_renderer_stats.section_culled_count, world_renderer_stats.section_occluded_count, world_renderer_stats.section_count), ui_renderer);
+  render_line(n++, fmt::format("draws: {} commands in {} calls", world_renderer_stats.draw_count, world_renderer_stats.draw_call_count), ui_renderer);
+  render_line(n++, fmt::format("entities: {} in {} draws", world_renderer_stats.entity_count, world_renderer_stats.entity_draw_call_count), ui_renderer);
+  render_line(n++, fmt::format("far terrain: {} tiles, {} pending, {} culled, {} vertices", world_renderer_stats.far_terrain.tile_count, world_renderer_stats.far_terrain.tile_pending_count, world_renderer_stats.far_terrain.tile_culled_count, world_renderer_stats.far_terrain.vertex_count), ui_renderer);
+  for(int lod=0; lod<CHUNK_LOD_COUNT; ++lod)
+    render_line(n++, fmt::format("lod {}: {} chunks, {} vertices", lod, world_renderer_stats.lod_chunk_counts[lod], world_renderer_stats.lod_vertex_counts[lod]), ui_renderer);
+
+  const graphics::Mesh::Stats& mesh_stats = graphics::Mesh::total_stats();
+  render_line(n++, fmt::format("mesh buffers: {} writes, {} allocations, {} waits", mesh_stats.write_count, mesh_stats.allocation_count, mesh_stats.wait_count), ui_renderer);
+
+  n = render_thread_pool_stats(n, ui_renderer);
+  n = render_profiler_stats(n, ui_renderer);
+  n = render_memory_stats(n, ui_renderer);
+
+  ui_renderer.flush(viewport);
+}
+
+size_t DebugRenderer::render_thread_pool_stats(size_t n, graphics::UIRenderer& ui_renderer)
+{
+  ThreadPool::Stats stats = ThreadPool::instance().stats();
+
+  // Utilisation is only meaningful over a window, so we compare against a
+  // snapshot that is refreshed every THREAD_POOL_STATS_INTERVAL seconds.
+  ThreadPool::Clock::time_point now = ThreadPool::Clock::now();
+  if(std::chrono::duration<float>(now - m_thread_pool_stats_time).count() >= THREAD_POOL_STATS_INTERVAL)
+  {
+    m_thread_pool_utilisations = stats.utilisations(&m_thread_pool_stats);
+    m_thread_pool_stats        = stats;
+    m_thread_pool_stats_time   = now;
+  }
+
+  float utilisation = 0.0f;
+  for(float worker_utilisation : m_thread_pool_utilisations)
+    utilisation += worker_utilisation;
+  if(!m_thread_pool_utilisations.empty())
+    utilisation /= m_thread_pool_utilisations.size();
+
+  render_line(n++, fmt::format("thread pool: queue depth = {}, workers = {}, utilisation = {:.1f}%", stats.queue_depth, stats.workers.size(), utilisation * 100.0f), ui_renderer);
+  for(size_t i=0; i<static_cast<size_t>(TaskKind::COUNT); ++i)
+  {
+    const ThreadPool::KindStats& kind = stats.kinds[i];
+    if(kind.enqueued == 0)
+      continue;
+
+    render_line(n++, fmt::format("  {}: enqueued = {}, started = {}, completed = {}, pending = {}, wait = {:.0f}us (p90 {:.0f}us), run = {:.0f}us (p90 {:.0f}us)",
+      task_kind_name(static_cast<TaskKind>(i)), kind.enqueued, kind.started, kind.completed, kind.pending,
+      kind.wait_time.average_us(), kind.wait_time.percentile_us(0.9f),
+      kind.run_time .average_us(), kind.run_time .percentile_us(0.9f)), ui_renderer);
+  }
+  return n;
+}
+
+size_t DebugRenderer::render_profiler_stats(size_t n, graphics::UIRenderer& ui_renderer)
+{
+  // Averaged over Profiler::AVERAGE_INTERVAL, most expensive zones first
+  render_line(n++, "profiler:", ui_renderer);
+  for(const Profiler::ZoneAverage& zone : Profiler::instance().averages())
+    render_line(n++, fmt::format("  {}: {:.0f}us (max {:.0f}us), {:.1f}/s", zone.name, zone.average_us, zone.max_us, zone.count_per_second), ui_renderer);
+  return n;
+}
+
+size_t DebugRenderer::render_memory_stats(size_t n, graphics::UIRenderer& ui_renderer)
+{
+  std::vector<MemoryRegistry::Entry> entries = MemoryRegistry::instance().entries();
+
+  std::int64_t total = 0;
+  for(const MemoryRegistry::Entry& entry : entries)
+    total += entry.bytes;
+
+  render_line(n++, fmt::format("memory: {:.1f} MiB", total / (1024.0 * 1024.0)), ui_renderer);
+  for(const MemoryRegistry::Entry& entry : entries)
+    render_line(n++, fmt::format("  {}: {:.0f} KiB ({} objects)", entry.name, entry.bytes / 1024.0, entry.count), ui_renderer);
+  return n;
 }
 
-void DebugRenderer::render_line(glm::vec2 viewport, size_t n, const std::string& line, graphics::UIRenderer& ui_renderer)
+void DebugRenderer::render_line(size_t n, const std::string& line, graphics::UIRenderer& ui_renderer)
 {
   glm::vec2 position = DEBUG_MARGIN + glm::vec2(0.0f, n * DEBUG_FONT_HEIGHT);
-  m_font->render(ui_renderer, viewport, position, line.c_str());
+  m_font->render(ui_renderer, position, line.c_str());
 }
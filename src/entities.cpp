@@ -0,0 +1,101 @@
+#include <entities.hpp>
+
+#include <assert.h>
+
+template<typename T>
+static void swap_remove(std::vector<T>& values, size_t index)
+{
+  values[index] = std::move(values.back());
+  values.pop_back();
+}
+
+EntityHandle Entities::create(std::uint16_t id, Transform transform, glm::vec3 dimension, float eye)
+{
+  std::uint32_t slot;
+  if(!m_free_slots.empty())
+  {
+    slot = m_free_slots.back();
+    m_free_slots.pop_back();
+  }
+  else
+  {
+    slot = m_slots.size();
+    m_slots.push_back(Slot{ .index = 0, .generation = 0 });
+  }
+
+  m_slots[slot].index = m_dense_slots.size();
+  m_dense_slots.push_back(slot);
+
+  physics.positions .push_back(transform.position);
+  physics.velocities.push_back(glm::vec3(0.0f));
+  physics.dimensions.push_back(dimension);
+  physics.collided  .push_back(false);
+  physics.grounded  .push_back(false);
+  physics.idle_ticks.push_back(0);
+  physics.sleeping  .push_back(false);
+
+  transforms.rotations.push_back(transform.rotation);
+  transforms.eyes     .push_back(eye);
+
+  render.ids.push_back(id);
+
+  return EntityHandle{ .slot = slot, .generation = m_slots[slot].generation };
+}
+
+void Entities::destroy(EntityHandle handle)
+{
+  size_t index = this->index(handle);
+
+  // Move the last entity into the hole so that the arrays stay packed
+  std::uint32_t last_slot = m_dense_slots.back();
+  m_slots[last_slot].index = index;
+
+  swap_remove(m_dense_slots, index);
+
+  swap_remove(physics.positions,  index);
+  swap_remove(physics.velocities, index);
+  swap_remove(physics.dimensions, index);
+  swap_remove(physics.collided,   index);
+  swap_remove(physics.grounded,   index);
+  swap_remove(physics.idle_ticks, index);
+  swap_remove(physics.sleeping,   index);
+
+  swap_remove(transforms.rotations, index);
+  swap_remove(transforms.eyes,      index);
+
+  swap_remove(render.ids, index);
+
+  ++m_slots[handle.slot].generation;
+  m_free_slots.push_back(handle.slot);
+}
+
+bool Entities::valid(EntityHandle handle) const
+{
+  return handle.slot < m_slots.size() && m_slots[handle.slot].generation == handle.generation;
+}
+
+size_t Entities::index(EntityHandle handle) const
+{
+  assert(valid(handle));
+  return m_slots[handle.slot].index;
+}
+
+EntityHandle Entities::handle(size_t index) const
+{
+  std::uint32_t slot = m_dense_slots.at(index);
+  return EntityHandle{ .slot = slot, .generation = m_slots[slot].generation };
+}
+
+Transform Entities::transform(size_t index) const
+{
+  return Transform{
+    .position = physics.positions[index],
+    .rotation = transforms.rotations[index],
+  };
+}
+
+void Entities::set_transform(size_t index, const Transform& transform)
+{
+  physics.positions[index]    = transform.position;
+  transforms.rotations[index] = transform.rotation;
+}
@@ -0,0 +1,225 @@
+#include <far_terrain_renderer.hpp>
+
+#include <frustum.hpp>
+
+#include <algorithm>
+#include <limits>
+
+#include <math.h>
+
+static constexpr int   REGION_BLOCK_WIDTH = FarTerrainRenderer::REGION_WIDTH * CHUNK_WIDTH;
+static constexpr int   TILE_VERTEX_WIDTH  = FarTerrainRenderer::REGION_RESOLUTION + 1;
+static constexpr float TILE_STEP          = static_cast<float>(REGION_BLOCK_WIDTH) / FarTerrainRenderer::REGION_RESOLUTION;
+
+struct FarTerrainVertex
+{
+  glm::vec3 position;
+  glm::vec3 normal;
+  uint32_t  texture_index;
+};
+
+static constexpr graphics::Attribute FAR_TERRAIN_VERTEX_ATTRIBUTES[] = {
+  { .type = graphics::AttributeType::FLOAT3,        .offset = offsetof(FarTerrainVertex, position),      },
+  { .type = graphics::AttributeType::FLOAT3,        .offset = offsetof(FarTerrainVertex, normal),        },
+  { .type = graphics::AttributeType::UNSIGNED_INT1, .offset = offsetof(FarTerrainVertex, texture_index), },
+};
+
+// Every tile has the same grid topology, so they all share one index buffer,
+// wound the same way as the top faces of chunk meshes
+static std::vector<uint32_t> grid_indices()
+{
+  std::vector<uint32_t> indices;
+  for(int y=0; y<FarTerrainRenderer::REGION_RESOLUTION; ++y)
+    for(int x=0; x<FarTerrainRenderer::REGION_RESOLUTION; ++x)
+    {
+      uint32_t index_base = y * TILE_VERTEX_WIDTH + x;
+      indices.push_back(index_base);
+      indices.push_back(index_base + 1);
+      indices.push_back(index_base + TILE_VERTEX_WIDTH);
+      indices.push_back(index_base + TILE_VERTEX_WIDTH);
+      indices.push_back(index_base + 1);
+      indices.push_back(index_base + TILE_VERTEX_WIDTH + 1);
+    }
+  return indices;
+}
+
+FarTerrainRenderer::FarTerrainRenderer(const WorldGenerationConfig& config) : m_stats{}
+{
+  m_sampler = std::make_shared<const TerrainSampler>(config.seed, config.terrain);
+
+  m_shader_program = std::make_unique<graphics::ShaderProgram>("assets/far_terrain.vert", "assets/far_terrain.frag");
+
+  size_t tile_count = (2 * RADIUS + 1) * (2 * RADIUS + 1);
+  m_arena = std::make_unique<graphics::MeshArena>(sizeof(FarTerrainVertex), FAR_TERRAIN_VERTEX_ATTRIBUTES, tile_count * TILE_VERTEX_WIDTH * TILE_VERTEX_WIDTH);
+  m_arena->set_indices(grid_indices());
+
+  // Nearest first, so that the tiles closest to the loaded chunks are
+  // requested first
+  for(int dy=-RADIUS; dy<=RADIUS; ++dy)
+    for(int dx=-RADIUS; dx<=RADIUS; ++dx)
+      m_region_offsets.push_back(glm::ivec2(dx, dy));
+  std::sort(m_region_offsets.begin(), m_region_offsets.end(), [](glm::ivec2 offset1, glm::ivec2 offset2) {
+    return offset1.x * offset1.x + offset1.y * offset1.y < offset2.x * offset2.x + offset2.y * offset2.y;
+  });
+}
+
+FarTerrainRenderer::TileData FarTerrainRenderer::generate_tile(const TerrainSampler& sampler, glm::ivec2 region)
+{
+  // Sampling the noise is by far the most expensive part, so sample every
+  // point only once, on a grid with an extra ring around the tile so that
+  // normals can be computed with central differences that match up across
+  // tile borders
+  static constexpr int SAMPLE_WIDTH = TILE_VERTEX_WIDTH + 2;
+
+  glm::vec2 origin = glm::vec2(region) * static_cast<float>(REGION_BLOCK_WIDTH);
+
+  std::vector<TerrainSampler::Sample> samples;
+  samples.reserve(SAMPLE_WIDTH * SAMPLE_WIDTH);
+  for(int y=-1; y<TILE_VERTEX_WIDTH+1; ++y)
+    for(int x=-1; x<TILE_VERTEX_WIDTH+1; ++x)
+    {
+      TerrainSampler::Sample sample = sampler.sample(origin + glm::vec2(x, y) * TILE_STEP);
+      sample.height = std::ceil(sample.height);
+      samples.push_back(sample);
+    }
+
+  auto sample_at = [&](int x, int y) -> const TerrainSampler::Sample& { return samples[(y + 1) * SAMPLE_WIDTH + (x + 1)]; };
+
+  TileData tile = { .samples = {}, .min_height = std::numeric_limits<float>::infinity(), .max_height = -std::numeric_limits<float>::infinity() };
+  tile.samples.reserve(TILE_VERTEX_WIDTH * TILE_VERTEX_WIDTH);
+  for(int y=0; y<TILE_VERTEX_WIDTH; ++y)
+    for(int x=0; x<TILE_VERTEX_WIDTH; ++x)
+    {
+      const TerrainSampler::Sample& sample = sample_at(x, y);
+
+      float dx = sample_at(x + 1, y).height - sample_at(x - 1, y).height;
+      float dy = sample_at(x, y + 1).height - sample_at(x, y - 1).height;
+
+      tile.samples.push_back(TileSample{
+        .position = glm::vec3(origin + glm::vec2(x, y) * TILE_STEP, sample.height),
+        .normal   = glm::normalize(glm::vec3(-dx, -dy, 2.0f * TILE_STEP)),
+        .block_id = sample.block_id,
+      });
+      tile.min_height = std::min(tile.min_height, sample.height);
+      tile.max_height = std::max(tile.max_height, sample.height);
+    }
+  return tile;
+}
+
+void FarTerrainRenderer::render(const graphics::Camera& camera, const ResourcePack& resource_pack, glm::vec2 center, float inner_radius)
+{
+  m_stats = {};
+
+  // 1: Upload the tiles that are done, and evict the ones that have gone out
+  //    of range. Tiles still being built are left alone until they are done,
+  //    since destroying a Lazy waits for it.
+  glm::ivec2 camera_region = glm::floor(glm::vec2(camera.transform.position) / static_cast<float>(REGION_BLOCK_WIDTH));
+
+  std::vector<FarTerrainVertex> vertices;
+  for(auto it = m_tiles.begin(); it != m_tiles.end();)
+  {
+    auto& [region, tile] = *it;
+    if(tile.pending)
+    {
+      TileData *data = tile.pending->try_get();
+      if(!data)
+      {
+        ++m_stats.tile_pending_count;
+        ++it;
+        continue;
+      }
+
+      vertices.clear();
+      for(const TileSample& sample : data->samples)
+        vertices.push_back(FarTerrainVertex{
+          .position      = sample.position,
+          .normal        = sample.normal,
+          .texture_index = resource_pack.blocks.at(sample.block_id).texture_indices[5], // Top face
+        });
+
+      tile.allocation = m_arena->allocate(std::as_bytes(std::span(vertices)));
+      tile.min_height = data->min_height;
+      tile.max_height = data->max_height;
+      tile.pending.reset();
+    }
+
+    glm::ivec2 offset = region - camera_region;
+    if(std::abs(offset.x) > RADIUS + 1 || std::abs(offset.y) > RADIUS + 1)
+    {
+      m_arena->free(tile.allocation);
+      it = m_tiles.erase(it);
+      continue;
+    }
+
+    ++it;
+  }
+
+  // 2: Request tiles for the nearest regions in range that do not have one,
+  //    keeping at most MAX_PENDING_TILE_COUNT of them in the thread pool
+  for(glm::ivec2 offset : m_region_offsets)
+  {
+    if(m_stats.tile_pending_count >= MAX_PENDING_TILE_COUNT)
+      break;
+
+    glm::ivec2 region = camera_region + offset;
+    if(m_tiles.contains(region))
+      continue;
+
+    Tile& tile = m_tiles[region];
+    tile.pending = std::make_unique<Lazy<TileData>>(TaskKind::FAR_TERRAIN, [sampler=m_sampler, region]() {
+      return generate_tile(*sampler, region);
+    });
+    ++m_stats.tile_pending_count;
+  }
+
+  // 3: Draw every tile in range that is in the view frustum and not entirely
+  //    covered by loaded chunks
+  glm::mat4 view       = camera.view();
+  glm::mat4 projection = camera.projection();
+  Frustum   frustum    = Frustum::from_matrix(projection * view);
+
+  m_draw_commands.clear();
+  for(const auto& [region, tile] : m_tiles)
+  {
+    if(tile.pending)
+      continue;
+
+    glm::ivec2 offset = region - camera_region;
+    if(std::abs(offset.x) > RADIUS || std::abs(offset.y) > RADIUS)
+      continue;
+
+    ++m_stats.tile_count;
+
+    glm::vec2 tile_min = glm::vec2(region) * static_cast<float>(REGION_BLOCK_WIDTH);
+    glm::vec2 tile_max = tile_min + glm::vec2(static_cast<float>(REGION_BLOCK_WIDTH));
+    glm::vec2 farthest = glm::max(glm::abs(tile_min - center), glm::abs(tile_max - center));
+    AABB      aabb     = {
+      .position  = glm::vec3(tile_min, tile.min_height),
+      .dimension = glm::vec3(tile_max - tile_min, tile.max_height - tile.min_height),
+    };
+    if(glm::length(farthest) < inner_radius || !frustum.intersects(aabb))
+    {
+      ++m_stats.tile_culled_count;
+      continue;
+    }
+
+    m_stats.vertex_count += tile.allocation.vertex_count;
+    m_draw_commands.push_back(graphics::DrawElementsIndirectCommand{
+      .count          = static_cast<GLuint>(m_arena->index_count()),
+      .instance_count = 1,
+      .first_index    = 0,
+      .base_vertex    = static_cast<GLint>(tile.allocation.vertex_offset),
+      .base_instance  = 0,
+    });
+  }
+
+  m_shader_program->use();
+  m_shader_program->set_uniform("center",      center);
+  m_shader_program->set_uniform("innerRadius", inner_radius);
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, resource_pack.blocks_texture_array->id());
+  m_shader_program->set_uniform("blocksTextureArray", 0);
+
+  m_arena->draw(m_draw_commands);
+}
@@ -0,0 +1,111 @@
+#include <free_list_allocator.hpp>
+
+#include <assert.h>
+
+FreeListAllocator::FreeListAllocator(size_t capacity) : m_capacity(capacity), m_used(0)
+{
+  if(capacity != 0)
+    insert_free(0, capacity);
+}
+
+std::optional<size_t> FreeListAllocator::allocate(size_t size)
+{
+  if(size == 0)
+    return std::nullopt;
+
+  // Best-fit: the smallest free range that is large enough
+  auto by_size = m_free_by_size.lower_bound(size);
+  if(by_size == m_free_by_size.end())
+    return std::nullopt;
+
+  size_t offset    = by_size->second;
+  size_t free_size = by_size->first;
+  erase_free(m_free_by_offset.find(offset));
+  if(free_size != size)
+    insert_free(offset + size, free_size - size);
+
+  m_allocations.emplace(offset, size);
+  m_used += size;
+  return offset;
+}
+
+void FreeListAllocator::free(size_t offset)
+{
+  auto allocation = m_allocations.find(offset);
+  assert(allocation != m_allocations.end());
+
+  size_t size = allocation->second;
+  m_allocations.erase(allocation);
+  m_used -= size;
+
+  // Merge with the free range right after us, if any
+  auto next = m_free_by_offset.find(offset + size);
+  if(next != m_free_by_offset.end())
+  {
+    size += next->second;
+    erase_free(next);
+  }
+
+  // Merge with the free range right before us, if any
+  auto prev = m_free_by_offset.lower_bound(offset);
+  if(prev != m_free_by_offset.begin())
+  {
+    --prev;
+    if(prev->first + prev->second == offset)
+    {
+      offset = prev->first;
+      size  += prev->second;
+      erase_free(prev);
+    }
+  }
+
+  insert_free(offset, size);
+}
+
+void FreeListAllocator::grow(size_t capacity)
+{
+  assert(capacity >= m_capacity);
+  if(capacity == m_capacity)
+    return;
+
+  size_t offset = m_capacity;
+  size_t size   = capacity - m_capacity;
+  m_capacity = capacity;
+
+  // Merge with a free range that ends where the old space did
+  if(!m_free_by_offset.empty())
+  {
+    auto last = std::prev(m_free_by_offset.end());
+    if(last->first + last->second == offset)
+    {
+      offset = last->first;
+      size  += last->second;
+      erase_free(last);
+    }
+  }
+
+  insert_free(offset, size);
+}
+
+size_t FreeListAllocator::largest_free() const
+{
+  return !m_free_by_size.empty() ? std::prev(m_free_by_size.end())->first : 0;
+}
+
+void FreeListAllocator::insert_free(size_t offset, size_t size)
+{
+  m_free_by_offset.emplace(offset, size);
+  m_free_by_size.emplace(size, offset);
+}
+
+void FreeListAllocator::erase_free(std::map<size_t, size_t>::iterator it)
+{
+  auto [begin, end] = m_free_by_size.equal_range(it->second);
+  for(auto by_size = begin; by_size != end; ++by_size)
+    if(by_size->second == it->first)
+    {
+      m_free_by_size.erase(by_size);
+      break;
+    }
+  m_free_by_offset.erase(it);
+}
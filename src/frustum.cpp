@@ -0,0 +1,38 @@
+#include <frustum.hpp>
+
+Frustum Frustum::from_matrix(const glm::mat4& view_projection)
+{
+  // glm is column-major, so row i of the matrix is m[*][i]
+  glm::vec4 rows[4];
+  for(int i=0; i<4; ++i)
+    rows[i] = glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+
+  Frustum frustum;
+  frustum.planes[0] = rows[3] + rows[0]; // Left
+  frustum.planes[1] = rows[3] - rows[0]; // Right
+  frustum.planes[2] = rows[3] + rows[1]; // Bottom
+  frustum.planes[3] = rows[3] - rows[1]; // Top
+  frustum.planes[4] = rows[3] + rows[2]; // Near
+  frustum.planes[5] = rows[3] - rows[2]; // Far
+  for(glm::vec4& plane : frustum.planes)
+    plane /= glm::length(glm::vec3(plane));
+  return frustum;
+}
+
+bool Frustum::intersects(const AABB& aabb) const
+{
+  for(const glm::vec4& plane : planes)
+  {
+    // Test the corner of the box furthest along the plane normal. If even
+    // that is outside, so is the whole box.
+    glm::vec3 normal = glm::vec3(plane);
+    glm::vec3 corner = aabb.position;
+    for(int i=0; i<3; ++i)
+      if(normal[i] > 0.0f)
+        corner[i] += aabb.dimension[i];
+
+    if(glm::dot(normal, corner) + plane.w < 0.0f)
+      return false;
+  }
+  return true;
+}
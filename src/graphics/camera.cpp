@@ -18,7 +18,7 @@ namespace graphics
     axis_adjust[1][2] = -1.0f; // our y-axis goes to -ve z-axis in OpenGL
     axis_adjust[2][1] =  1.0f; // our z-axis goes to +ve y-axis in OpenGL
     axis_adjust[3][3] =  1.0f; // Keep w-component
-    return glm::perspective(glm::radians(fovy), aspect, 0.1f, 500.0f) * axis_adjust;
+    return glm::perspective(glm::radians(fovy), aspect, 0.1f, 2000.0f) * axis_adjust;
   }
 
   void Camera::zoom(float factor)
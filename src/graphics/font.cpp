@@ -3,6 +3,10 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
 namespace graphics
 {
   Font::Font(const char *font, unsigned height)
@@ -19,37 +23,62 @@ namespace graphics
     if(FT_Set_Pixel_Sizes(face, 0, height) != 0)
       throw std::runtime_error("Failed to set pixel sizes");
 
+    // Pack glyphs left to right in rows, with a pixel of padding so that
+    // filtering never bleeds into a neighbour
+    std::vector<unsigned char> pixels;
+    unsigned atlas_height = 0;
+    unsigned row_height   = 0;
+    unsigned x = 0, y = 0;
     for(int c = 0; c<128; ++c)
     {
       if(FT_Load_Char(face, c, FT_LOAD_RENDER) != 0)
         throw std::runtime_error("Failed to load character");
 
-      m_glyphs[c].dimenson.x = face->glyph->bitmap.width;
-      m_glyphs[c].dimenson.y = face->glyph->bitmap.rows;
+      const FT_Bitmap& bitmap = face->glyph->bitmap;
+      if(bitmap.width + 1 > ATLAS_WIDTH)
+        throw std::runtime_error("Glyph too wide for font atlas");
+
+      if(x + bitmap.width + 1 > ATLAS_WIDTH)
+      {
+        x  = 0;
+        y += row_height + 1;
+        row_height = 0;
+      }
+      row_height = std::max(row_height, bitmap.rows);
+
+      atlas_height = std::max(atlas_height, y + bitmap.rows + 1);
+      pixels.resize(ATLAS_WIDTH * atlas_height);
+      for(unsigned row = 0; row<bitmap.rows; ++row)
+        std::copy_n(bitmap.buffer + row * bitmap.pitch, bitmap.width, pixels.data() + (y + row) * ATLAS_WIDTH + x);
+
+      m_glyphs[c].dimension.x = bitmap.width;
+      m_glyphs[c].dimension.y = bitmap.rows;
 
       m_glyphs[c].bearing.x = face->glyph->bitmap_left;
-      m_glyphs[c].bearing.y = -(int)face->glyph->bitmap.rows+(int)face->glyph->bitmap_top;
+      m_glyphs[c].bearing.y = -(int)bitmap.rows+(int)face->glyph->bitmap_top;
 
       m_glyphs[c].advance.x = face->glyph->advance.x / 64.0f;
       m_glyphs[c].advance.y = face->glyph->advance.y / 64.0f;
 
-      m_glyphs[c].texture = std::make_unique<graphics::Texture>(face->glyph->bitmap.buffer, face->glyph->bitmap.width, face->glyph->bitmap.rows, 1);
+      m_glyphs[c].texture_min = glm::vec2(x, y);
+      m_glyphs[c].texture_max = glm::vec2(x + bitmap.width, y + bitmap.rows);
+
+      x += bitmap.width + 1;
     }
 
+    for(Glyph& glyph : m_glyphs)
+    {
+      glyph.texture_min /= glm::vec2(ATLAS_WIDTH, atlas_height);
+      glyph.texture_max /= glm::vec2(ATLAS_WIDTH, atlas_height);
+    }
+    m_atlas = std::make_unique<graphics::Texture>(pixels.data(), ATLAS_WIDTH, atlas_height, 1);
+
     FT_Done_Face(face);
     FT_Done_FreeType(library);
   }
 
-  void Font::render(UIRenderer& renderer, glm::vec2 viewport, glm::vec2 position, const char* str)
+  void Font::render(UIRenderer& renderer, glm::vec2 position, const char* str) const
   {
-    for(const char *it = str; *it; ++it)
-    {
-      int c = *it;
-      assert(c >= 0 && c < 128);
-
-      const Glyph& glyph = m_glyphs[c];
-      renderer.render(viewport, position + glyph.bearing, glyph.dimenson, *glyph.texture);
-      position += glyph.advance;
-    }
+    renderer.batch().push_text(m_glyphs, *m_atlas, position, str);
   }
 }
@@ -0,0 +1,34 @@
+#include <graphics/frame_uniforms.hpp>
+
+namespace graphics
+{
+  static_assert(sizeof(FrameUniforms) == 3 * 64 + 16 + 16, "FrameUniforms must match the std140 layout of the Frame block");
+
+  FrameUniformBuffer::FrameUniformBuffer()
+  {
+    glGenBuffers(1, &m_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, m_ubo);
+  }
+
+  FrameUniformBuffer::~FrameUniformBuffer()
+  {
+    glDeleteBuffers(1, &m_ubo);
+  }
+
+  void FrameUniformBuffer::update(const Camera& camera)
+  {
+    FrameUniforms uniforms = {};
+    uniforms.view            = camera.view();
+    uniforms.projection      = camera.projection();
+    uniforms.view_projection = uniforms.projection * uniforms.view;
+    uniforms.sky_color       = glm::vec4(SKY_COLOR, 1.0f);
+    uniforms.fog_density     = FOG_DENSITY;
+    uniforms.fog_gradient    = FOG_GRADIENT;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(uniforms), &uniforms);
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, m_ubo);
+  }
+}
@@ -1,109 +1,413 @@
 #include <graphics/mesh.hpp>
 
+#include <memory_registry.hpp>
+
 #include <tiny_obj_loader.h>
 
 #include <spdlog/spdlog.h>
+#include <fmt/format.h>
 
 #include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+
+#include <string.h>
+#include <assert.h>
 
 namespace graphics
 {
-  std::unique_ptr<Mesh> Mesh::load_from(const std::string& filename)
+  void configure_attributes(size_t stride, std::span<const Attribute> attributes, GLuint first_location, GLuint divisor)
   {
-    struct Vertex
+    for(std::size_t j=0; j<attributes.size(); ++j)
     {
-      glm::vec3 position;
-      glm::vec3 normal;
-      glm::vec2 texture_coords;
-    };
+      GLuint i = first_location + j;
+      glEnableVertexAttribArray(i);
+      switch(attributes[j].type)
+      {
+        case AttributeType::FLOAT1: glVertexAttribPointer(i, 1, GL_FLOAT, GL_FALSE, stride, (void*)attributes[j].offset); break;
+        case AttributeType::FLOAT2: glVertexAttribPointer(i, 2, GL_FLOAT, GL_FALSE, stride, (void*)attributes[j].offset); break;
+        case AttributeType::FLOAT3: glVertexAttribPointer(i, 3, GL_FLOAT, GL_FALSE, stride, (void*)attributes[j].offset); break;
+        case AttributeType::FLOAT4: glVertexAttribPointer(i, 4, GL_FLOAT, GL_FALSE, stride, (void*)attributes[j].offset); break;
+
+        case AttributeType::UNSIGNED_INT1: glVertexAttribIPointer(i, 1, GL_UNSIGNED_INT, stride, (void*)attributes[j].offset); break;
+        case AttributeType::UNSIGNED_INT2: glVertexAttribIPointer(i, 2, GL_UNSIGNED_INT, stride, (void*)attributes[j].offset); break;
+        case AttributeType::UNSIGNED_INT3: glVertexAttribIPointer(i, 3, GL_UNSIGNED_INT, stride, (void*)attributes[j].offset); break;
+        case AttributeType::UNSIGNED_INT4: glVertexAttribIPointer(i, 4, GL_UNSIGNED_INT, stride, (void*)attributes[j].offset); break;
+      }
+      glVertexAttribDivisor(i, divisor);
+    }
+  }
+
+  /**************
+   * OBJ meshes *
+   **************/
+  struct ObjVertex
+  {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texture_coords;
+  };
+
+  // Vertices are welded by their exact bits, which is what tinyobj hands out
+  // for every corner referring to the same position, normal and uv
+  struct ObjVertexHash
+  {
+    size_t operator()(const ObjVertex& vertex) const
+    {
+      // 64-bit FNV-1a
+      std::uint64_t hash = 0xcbf29ce484222325;
+      const unsigned char *bytes = reinterpret_cast<const unsigned char*>(&vertex);
+      for(size_t i=0; i<sizeof vertex; ++i)
+      {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3;
+      }
+      return hash;
+    }
+  };
+
+  struct ObjVertexEqual
+  {
+    bool operator()(const ObjVertex& lhs, const ObjVertex& rhs) const
+    {
+      return memcmp(&lhs, &rhs, sizeof(ObjVertex)) == 0;
+    }
+  };
+
+  static_assert(sizeof(ObjVertex) == 8 * sizeof(float), "ObjVertex must not have padding, since it is hashed and cached as bytes");
+
+  struct ObjMesh
+  {
+    std::vector<ObjVertex>     vertices;
+    std::vector<std::uint32_t> indices;
+  };
 
+  static ObjMesh parse_obj(const std::string& filename)
+  {
     tinyobj::ObjReader reader;
-    reader.ParseFromFile(filename);
+    if(!reader.ParseFromFile(filename))
+      throw std::runtime_error(fmt::format("Failed to load mesh {}: {}", filename, reader.Error()));
 
     const auto& attrib = reader.GetAttrib();
 
-    std::vector<Vertex>   vertices;
-    std::vector<unsigned> indices;
+    ObjMesh mesh;
+    std::unordered_map<ObjVertex, std::uint32_t, ObjVertexHash, ObjVertexEqual> vertex_indices;
 
     const auto& shapes = reader.GetShapes();
     for(const auto& shape : shapes)
       for(const auto& index : shape.mesh.indices)
       {
-        vertices.push_back(Vertex{
-          .position = glm::vec3(
-              attrib.vertices[index.vertex_index*3+0],
-              attrib.vertices[index.vertex_index*3+1],
-              attrib.vertices[index.vertex_index*3+2]
-          ),
-          .normal = glm::vec3(
+        // Normals and texture coordinates are optional in OBJ
+        ObjVertex vertex = {};
+        vertex.position = glm::vec3(
+            attrib.vertices[index.vertex_index*3+0],
+            attrib.vertices[index.vertex_index*3+1],
+            attrib.vertices[index.vertex_index*3+2]
+        );
+        if(index.normal_index >= 0)
+          vertex.normal = glm::vec3(
               attrib.normals[index.normal_index*3+0],
               attrib.normals[index.normal_index*3+1],
               attrib.normals[index.normal_index*3+2]
-          ),
-          .texture_coords = glm::vec2(
+          );
+        if(index.texcoord_index >= 0)
+          vertex.texture_coords = glm::vec2(
               attrib.texcoords[index.texcoord_index*2+0],
               attrib.texcoords[index.texcoord_index*2+1]
-          ),
-        });
-        indices.push_back(indices.size());
+          );
+
+        auto [it, inserted] = vertex_indices.try_emplace(vertex, mesh.vertices.size());
+        if(inserted)
+          mesh.vertices.push_back(vertex);
+        mesh.indices.push_back(it->second);
       }
 
+    return mesh;
+  }
+
+  // The binary cache sits next to the source, as <source>.bin, and is only
+  // used if the source still has the size and modification time it was
+  // cooked from. Indices are stored with the same width they are uploaded
+  // with.
+  static constexpr std::uint32_t OBJ_CACHE_MAGIC   = 0x4d4a424f; // "OBJM"
+  static constexpr std::uint32_t OBJ_CACHE_VERSION = 1;
+
+  struct ObjCacheHeader
+  {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t source_size;
+    std::int64_t  source_mtime;
+    std::uint32_t vertex_count;
+    std::uint32_t index_count;
+    std::uint32_t index_size;
+    std::uint32_t padding;
+  };
+
+  static ObjCacheHeader obj_cache_header(const std::string& filename)
+  {
+    return ObjCacheHeader{
+      .magic        = OBJ_CACHE_MAGIC,
+      .version      = OBJ_CACHE_VERSION,
+      .source_size  = std::filesystem::file_size(filename),
+      .source_mtime = std::filesystem::last_write_time(filename).time_since_epoch().count(),
+    };
+  }
+
+  // Indices that fit are narrowed to 16 bits
+  static bool obj_indices_fit_short(const ObjMesh& mesh)
+  {
+    return mesh.vertices.size() <= std::numeric_limits<std::uint16_t>::max() + size_t(1);
+  }
+
+  static bool read_obj_cache(const std::string& filename, ObjMesh& mesh)
+  {
+    std::ifstream ifs(filename + ".bin", std::ios::binary);
+    if(!ifs)
+      return false;
+
+    ObjCacheHeader expected = obj_cache_header(filename);
+    ObjCacheHeader header;
+    if(!ifs.read(reinterpret_cast<char*>(&header), sizeof header))
+      return false;
+
+    if(header.magic        != expected.magic       ||
+       header.version      != expected.version     ||
+       header.source_size  != expected.source_size ||
+       header.source_mtime != expected.source_mtime)
+      return false;
+
+    // The counts come from disk, so check them against what the file can
+    // actually hold before allocating anything
+    if(header.index_size != 2 && header.index_size != 4)
+      return false;
+
+    std::error_code ec;
+    std::uintmax_t  file_size = std::filesystem::file_size(filename + ".bin", ec);
+    if(ec || file_size != sizeof header + std::uintmax_t(header.vertex_count) * sizeof(ObjVertex) + std::uintmax_t(header.index_count) * header.index_size)
+      return false;
+
+    mesh.vertices.resize(header.vertex_count);
+    mesh.indices .resize(header.index_count);
+    if(!ifs.read(reinterpret_cast<char*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(ObjVertex)))
+      return false;
+
+    if(header.index_size == 2)
+    {
+      std::vector<std::uint16_t> indices(header.index_count);
+      if(!ifs.read(reinterpret_cast<char*>(indices.data()), indices.size() * sizeof(std::uint16_t)))
+        return false;
+      std::copy(indices.begin(), indices.end(), mesh.indices.begin());
+    }
+    else if(!ifs.read(reinterpret_cast<char*>(mesh.indices.data()), mesh.indices.size() * sizeof(std::uint32_t)))
+      return false;
+
+    // An index past the last vertex would have the GPU read out of bounds
+    return std::all_of(mesh.indices.begin(), mesh.indices.end(), [&](std::uint32_t index) { return index < header.vertex_count; });
+  }
+
+  static void write_obj_cache(const std::string& filename, const ObjMesh& mesh)
+  {
+    ObjCacheHeader header = obj_cache_header(filename);
+    header.vertex_count = mesh.vertices.size();
+    header.index_count  = mesh.indices.size();
+    header.index_size   = obj_indices_fit_short(mesh) ? 2 : 4;
+
+    std::ofstream ofs(filename + ".bin", std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof header);
+    ofs.write(reinterpret_cast<const char*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(ObjVertex));
+    if(header.index_size == 2)
+    {
+      std::vector<std::uint16_t> indices(mesh.indices.begin(), mesh.indices.end());
+      ofs.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(std::uint16_t));
+    }
+    else
+      ofs.write(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size() * sizeof(std::uint32_t));
+
+    if(!ofs)
+      spdlog::warn("Failed to write mesh cache to {}.bin", filename);
+  }
+
+  std::unique_ptr<Mesh> Mesh::load_from(const std::string& filename)
+  {
+    ObjMesh obj_mesh;
+    if(!read_obj_cache(filename, obj_mesh))
+    {
+      obj_mesh = parse_obj(filename);
+      write_obj_cache(filename, obj_mesh);
+    }
+
     const Attribute attributes[] = {
-      { .type = graphics::AttributeType::FLOAT3, .offset = offsetof(Vertex, position),       },
-      { .type = graphics::AttributeType::FLOAT3, .offset = offsetof(Vertex, normal),         },
-      { .type = graphics::AttributeType::FLOAT2, .offset = offsetof(Vertex, texture_coords), },
+      { .type = graphics::AttributeType::FLOAT3, .offset = offsetof(ObjVertex, position),       },
+      { .type = graphics::AttributeType::FLOAT3, .offset = offsetof(ObjVertex, normal),         },
+      { .type = graphics::AttributeType::FLOAT2, .offset = offsetof(ObjVertex, texture_coords), },
     };
 
-    std::unique_ptr<Mesh> mesh = std::make_unique<Mesh>(
-        IndexType::UNSIGNED_INT,
-        PrimitiveType::TRIANGLES,
-        sizeof(Vertex),
-        attributes
-    );
-    mesh->write(std::as_bytes(std::span(indices)), std::as_bytes(std::span(vertices)), Usage::STATIC);
+    std::unique_ptr<Mesh> mesh;
+    if(obj_indices_fit_short(obj_mesh))
+    {
+      std::vector<std::uint16_t> indices(obj_mesh.indices.begin(), obj_mesh.indices.end());
+      mesh = std::make_unique<Mesh>(IndexType::UNSIGNED_SHORT, PrimitiveType::TRIANGLES, sizeof(ObjVertex), attributes);
+      mesh->write(std::as_bytes(std::span(indices)), std::as_bytes(std::span(obj_mesh.vertices)), Usage::STATIC);
+    }
+    else
+    {
+      mesh = std::make_unique<Mesh>(IndexType::UNSIGNED_INT, PrimitiveType::TRIANGLES, sizeof(ObjVertex), attributes);
+      mesh->write(std::as_bytes(std::span(obj_mesh.indices)), std::as_bytes(std::span(obj_mesh.vertices)), Usage::STATIC);
+    }
     return mesh;
   }
 
+  static Mesh::Stats total_stats;
+
+  static MemoryRegistry::Gauge& mesh_memory()
+  {
+    static MemoryRegistry::Gauge& gauge = MemoryRegistry::instance().gauge("gpu.meshes");
+    return gauge;
+  }
+
+  const Mesh::Stats& Mesh::total_stats()
+  {
+    return graphics::total_stats;
+  }
+
   Mesh::Mesh(IndexType index_type, PrimitiveType primitive_type, size_t stride, std::span<const Attribute> attributes) :
     m_index_type(index_type),
     m_primitive_type(primitive_type),
-    m_element_count(0)
+    m_stride(stride),
+    m_attributes(attributes.begin(), attributes.end()),
+    m_element_count(0),
+    m_ebo{},
+    m_vbo{},
+    m_ibo{},
+    m_instance_stride(0),
+    m_streaming(false),
+    m_segment(0),
+    m_fences{},
+    m_stats{}
   {
     glGenVertexArrays(1, &m_vao);
-    glGenBuffers(1, &m_ebo);
-    glGenBuffers(1, &m_vbo);
+    reset_buffers();
+    mesh_memory().add(0, 1);
+  }
 
-    glBindVertexArray(m_vao);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  Mesh::~Mesh()
+  {
+    for(GLsync fence : m_fences)
+      if(fence)
+        glDeleteSync(fence);
 
-    for(std::size_t i=0; i<attributes.size(); ++i)
-    {
-      glEnableVertexAttribArray(i);
-      switch(attributes[i].type)
+    glDeleteVertexArrays(1, &m_vao);
+    glDeleteBuffers(1, &m_ebo.id);
+    glDeleteBuffers(1, &m_vbo.id);
+    if(m_ibo.id) glDeleteBuffers(1, &m_ibo.id);
+
+    mesh_memory().add(-static_cast<std::int64_t>(vertex_buffer_bytes() + m_ibo.capacity), -1);
+  }
+
+  size_t Mesh::vertex_buffer_bytes() const
+  {
+    size_t segment_count = m_streaming ? STREAM_SEGMENT_COUNT : 1;
+    return (m_ebo.capacity + m_vbo.capacity) * segment_count;
+  }
+
+  // Replace both buffers with fresh ones of zero capacity. This is needed
+  // whenever the storage of a buffer has to change in a way that
+  // glBufferData can not do, since storage allocated by glBufferStorage is
+  // immutable.
+  void Mesh::reset_buffers()
+  {
+    for(GLsync& fence : m_fences)
+      if(fence)
       {
-        case AttributeType::FLOAT1: glVertexAttribPointer(i, 1, GL_FLOAT, GL_FALSE, stride, (void*)attributes[i].offset); break;
-        case AttributeType::FLOAT2: glVertexAttribPointer(i, 2, GL_FLOAT, GL_FALSE, stride, (void*)attributes[i].offset); break;
-        case AttributeType::FLOAT3: glVertexAttribPointer(i, 3, GL_FLOAT, GL_FALSE, stride, (void*)attributes[i].offset); break;
-        case AttributeType::FLOAT4: glVertexAttribPointer(i, 4, GL_FLOAT, GL_FALSE, stride, (void*)attributes[i].offset); break;
-
-        case AttributeType::UNSIGNED_INT1: glVertexAttribIPointer(i, 1, GL_UNSIGNED_INT, stride, (void*)attributes[i].offset); break;
-        case AttributeType::UNSIGNED_INT2: glVertexAttribIPointer(i, 2, GL_UNSIGNED_INT, stride, (void*)attributes[i].offset); break;
-        case AttributeType::UNSIGNED_INT3: glVertexAttribIPointer(i, 3, GL_UNSIGNED_INT, stride, (void*)attributes[i].offset); break;
-        case AttributeType::UNSIGNED_INT4: glVertexAttribIPointer(i, 4, GL_UNSIGNED_INT, stride, (void*)attributes[i].offset); break;
+        glDeleteSync(fence);
+        fence = nullptr;
       }
+
+    if(m_ebo.id) glDeleteBuffers(1, &m_ebo.id);
+    if(m_vbo.id) glDeleteBuffers(1, &m_vbo.id);
+    mesh_memory().add(-static_cast<std::int64_t>(vertex_buffer_bytes()));
+
+    m_ebo = {};
+    m_vbo = {};
+    m_streaming = false;
+    m_segment   = 0;
+
+    glGenBuffers(1, &m_ebo.id);
+    glGenBuffers(1, &m_vbo.id);
+
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo.id);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo.id);
+    configure_attributes(m_stride, m_attributes);
+    glBindVertexArray(0);
+  }
+
+  void Mesh::configure_instance_attributes()
+  {
+    if(m_instance_attributes.empty())
+      return;
+
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_ibo.id);
+    configure_attributes(m_instance_stride, m_instance_attributes, m_attributes.size(), 1);
+    glBindVertexArray(0);
+  }
+
+  void Mesh::set_instance_layout(size_t stride, std::span<const Attribute> attributes)
+  {
+    if(!m_ibo.id)
+      glGenBuffers(1, &m_ibo.id);
+
+    m_instance_stride = stride;
+    m_instance_attributes.assign(attributes.begin(), attributes.end());
+    configure_instance_attributes();
+  }
+
+  void Mesh::write_instances(std::span<const std::byte> instances, Usage usage)
+  {
+    assert(m_ibo.id && "set_instance_layout() must be called first");
+
+    GLenum _usage;
+    switch(usage)
+    {
+    case Usage::STATIC:  _usage = GL_STATIC_DRAW; break;
+    case Usage::DYNAMIC: _usage = GL_DYNAMIC_DRAW; break;
+    case Usage::STREAM:  _usage = GL_STREAM_DRAW; break;
+    }
+
+    ++m_stats.write_count;
+    ++graphics::total_stats.write_count;
+
+    // Instances are usually rewritten every frame. Orphaning the old storage
+    // lets the driver hand out fresh memory instead of waiting for the
+    // previous frame's draws to finish with it. That is a new allocation as
+    // far as the driver is concerned, so it is counted as one.
+    if(usage == Usage::STREAM && m_ibo.capacity >= instances.size() && !instances.empty())
+    {
+      glBindBuffer(GL_ARRAY_BUFFER, m_ibo.id);
+      glBufferData(GL_ARRAY_BUFFER, m_ibo.capacity, nullptr, _usage);
+      count_allocation();
     }
+    write_buffer(GL_ARRAY_BUFFER, m_ibo, instances, _usage);
   }
 
-  Mesh::~Mesh()
+  void Mesh::count_allocation()
   {
-    glDeleteVertexArrays(1, &m_vao);
-    glDeleteBuffers(1, &m_ebo);
-    glDeleteBuffers(1, &m_vbo);
+    ++m_stats.allocation_count;
+    ++graphics::total_stats.allocation_count;
   }
 
   void Mesh::write(std::span<const std::byte> indices, std::span<const std::byte> vertices, Usage usage)
   {
+    ++m_stats.write_count;
+    ++graphics::total_stats.write_count;
+
     GLenum _usage;
     switch(usage)
     {
@@ -112,13 +416,17 @@ namespace graphics
     case Usage::STREAM:  _usage = GL_STREAM_DRAW; break;
     }
 
-    glBindVertexArray(0);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size(), indices.data(), _usage);
+    if(usage == Usage::STREAM)
+      write_stream(indices, vertices);
+    else
+    {
+      if(m_streaming)
+        reset_buffers();
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size(), vertices.data(), _usage);
+      glBindVertexArray(0);
+      write_buffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo, indices,  _usage);
+      write_buffer(GL_ARRAY_BUFFER,         m_vbo, vertices, _usage);
+    }
 
     switch(m_index_type)
     {
@@ -128,23 +436,114 @@ namespace graphics
     }
   }
 
+  void Mesh::write_buffer(GLenum target, Buffer& buffer, std::span<const std::byte> data, GLenum usage)
+  {
+    if(data.empty())
+      return;
+
+    glBindBuffer(target, buffer.id);
+    if(data.size() > buffer.capacity)
+    {
+      // The first write allocates exactly what is needed, since most meshes
+      // are only ever written once. Growing after that is geometric, so that
+      // meshes that are rewritten with slowly growing data settle quickly.
+      size_t old_capacity = buffer.capacity;
+      buffer.capacity = buffer.capacity == 0 ? data.size() : std::max(buffer.capacity * 2, data.size());
+      glBufferData(target, buffer.capacity, nullptr, usage);
+      mesh_memory().add(buffer.capacity - old_capacity);
+      count_allocation();
+    }
+    glBufferSubData(target, 0, data.size(), data.data());
+  }
+
+  void Mesh::write_stream(std::span<const std::byte> indices, std::span<const std::byte> vertices)
+  {
+    if(!m_streaming || indices.size() > m_ebo.capacity || vertices.size() > m_vbo.capacity)
+    {
+      // Both capacities stay multiples of the index size and the stride, so
+      // that segments can be addressed with an index offset and base vertex
+      size_t index_capacity  = std::max(m_ebo.capacity * 2, indices.size());
+      size_t vertex_capacity = std::max(m_vbo.capacity * 2, vertices.size());
+      reset_buffers();
+
+      const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+      for(auto [target, buffer, capacity] : { std::tuple(GL_ELEMENT_ARRAY_BUFFER, &m_ebo, index_capacity), std::tuple(GL_ARRAY_BUFFER, &m_vbo, vertex_capacity) })
+      {
+        if(capacity == 0)
+          continue;
+
+        glBindVertexArray(0);
+        glBindBuffer(target, buffer->id);
+        glBufferStorage(target, capacity * STREAM_SEGMENT_COUNT, nullptr, flags);
+        buffer->capacity = capacity;
+        buffer->mapping  = static_cast<std::byte*>(glMapBufferRange(target, 0, capacity * STREAM_SEGMENT_COUNT, flags));
+        mesh_memory().add(capacity * STREAM_SEGMENT_COUNT);
+        count_allocation();
+      }
+      m_streaming = true;
+    }
+    else
+    {
+      // Every draw that reads the current segment has already been issued, so
+      // fence it and move on to the oldest one
+      m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      m_segment = (m_segment + 1) % STREAM_SEGMENT_COUNT;
+
+      if(GLsync& fence = m_fences[m_segment])
+      {
+        if(glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+          ++m_stats.wait_count;
+          ++graphics::total_stats.wait_count;
+          while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000) == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+      }
+    }
+
+    if(!indices.empty())  memcpy(m_ebo.mapping + m_segment * m_ebo.capacity, indices.data(),  indices.size());
+    if(!vertices.empty()) memcpy(m_vbo.mapping + m_segment * m_vbo.capacity, vertices.data(), vertices.size());
+  }
+
   void Mesh::draw() const
   {
-    GLenum mode, type;
+    draw(0, m_element_count);
+  }
+
+  Mesh::DrawParameters Mesh::draw_parameters() const
+  {
+    DrawParameters parameters;
     switch(m_index_type)
     {
-    case IndexType::UNSIGNED_BYTE:  type = GL_UNSIGNED_BYTE;  break;
-    case IndexType::UNSIGNED_SHORT: type = GL_UNSIGNED_SHORT; break;
-    case IndexType::UNSIGNED_INT:   type = GL_UNSIGNED_INT;   break;
+    case IndexType::UNSIGNED_BYTE:  parameters.index_type = GL_UNSIGNED_BYTE;  parameters.index_size = 1; break;
+    case IndexType::UNSIGNED_SHORT: parameters.index_type = GL_UNSIGNED_SHORT; parameters.index_size = 2; break;
+    case IndexType::UNSIGNED_INT:   parameters.index_type = GL_UNSIGNED_INT;   parameters.index_size = 4; break;
     }
     switch(m_primitive_type)
     {
-    case PrimitiveType::LINES:     mode = GL_LINES;     break;
-    case PrimitiveType::TRIANGLES: mode = GL_TRIANGLES; break;
+    case PrimitiveType::LINES:     parameters.mode = GL_LINES;     break;
+    case PrimitiveType::TRIANGLES: parameters.mode = GL_TRIANGLES; break;
     }
 
+    // Streaming meshes draw from the segment that was written last
+    parameters.index_offset = m_streaming ? m_segment * m_ebo.capacity : 0;
+    parameters.base_vertex  = m_streaming ? m_segment * m_vbo.capacity / m_stride : 0;
+    return parameters;
+  }
+
+  void Mesh::draw(size_t first, size_t count) const
+  {
+    DrawParameters parameters = draw_parameters();
+    glBindVertexArray(m_vao);
+    glDrawElementsBaseVertex(parameters.mode, count, parameters.index_type, (void*)(parameters.index_offset + first * parameters.index_size), parameters.base_vertex);
+  }
+
+  void Mesh::draw_instanced(size_t first_instance, size_t instance_count) const
+  {
+    DrawParameters parameters = draw_parameters();
     glBindVertexArray(m_vao);
-    glDrawElements(mode, m_element_count, type, (void*)0);
+    glDrawElementsInstancedBaseVertexBaseInstance(parameters.mode, m_element_count, parameters.index_type, (void*)parameters.index_offset, instance_count, parameters.base_vertex, first_instance);
   }
 }
 
@@ -0,0 +1,142 @@
+#include <graphics/mesh_arena.hpp>
+
+#include <memory_registry.hpp>
+
+#include <algorithm>
+
+namespace graphics
+{
+  std::vector<uint32_t> quad_indices(size_t quad_count)
+  {
+    std::vector<uint32_t> indices;
+    indices.reserve(quad_count * 6);
+    for(size_t i=0; i<quad_count; ++i)
+    {
+      uint32_t index_base = i * 4;
+      indices.push_back(index_base + 0);
+      indices.push_back(index_base + 1);
+      indices.push_back(index_base + 2);
+      indices.push_back(index_base + 2);
+      indices.push_back(index_base + 1);
+      indices.push_back(index_base + 3);
+    }
+    return indices;
+  }
+
+  static MemoryRegistry::Gauge& arena_memory()
+  {
+    static MemoryRegistry::Gauge& gauge = MemoryRegistry::instance().gauge("gpu.mesh_arenas");
+    return gauge;
+  }
+
+  MeshArena::MeshArena(size_t stride, std::span<const Attribute> attributes, size_t vertex_capacity) :
+    m_stride(stride),
+    m_attributes(attributes.begin(), attributes.end()),
+    m_vertex_allocator(vertex_capacity),
+    m_index_count(0)
+  {
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glGenBuffers(1, &m_ebo);
+    glGenBuffers(1, &m_dbo);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertex_capacity * m_stride, nullptr, GL_DYNAMIC_DRAW);
+    arena_memory().add(vertex_capacity * m_stride, 1);
+
+    bind_buffers();
+  }
+
+  MeshArena::~MeshArena()
+  {
+    glDeleteVertexArrays(1, &m_vao);
+    glDeleteBuffers(1, &m_vbo);
+    glDeleteBuffers(1, &m_ebo);
+    glDeleteBuffers(1, &m_dbo);
+
+    // The indirect draw buffer is left out, it only holds one frame of
+    // commands
+    size_t bytes = m_vertex_allocator.capacity() * m_stride + m_index_count * sizeof(uint32_t);
+    arena_memory().add(-static_cast<std::int64_t>(bytes), -1);
+  }
+
+  void MeshArena::grow_buffer(GLuint& buffer, size_t old_size, size_t new_size)
+  {
+    GLuint new_buffer;
+    glGenBuffers(1, &new_buffer);
+
+    glBindBuffer(GL_COPY_READ_BUFFER,  buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, new_size, nullptr, GL_DYNAMIC_DRAW);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, old_size);
+
+    glDeleteBuffers(1, &buffer);
+    buffer = new_buffer;
+    arena_memory().add(new_size - old_size);
+  }
+
+  void MeshArena::bind_buffers()
+  {
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    configure_attributes(m_stride, m_attributes);
+    glBindVertexArray(0);
+  }
+
+  void MeshArena::set_indices(std::span<const uint32_t> indices)
+  {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_ebo);
+    glBufferData(GL_COPY_WRITE_BUFFER, indices.size_bytes(), indices.data(), GL_STATIC_DRAW);
+    arena_memory().add(static_cast<std::int64_t>(indices.size_bytes()) - static_cast<std::int64_t>(m_index_count * sizeof(uint32_t)));
+    m_index_count = indices.size();
+  }
+
+  MeshArena::Allocation MeshArena::allocate(std::span<const std::byte> vertices)
+  {
+    Allocation allocation = {};
+    if(vertices.empty())
+      return allocation;
+
+    allocation.vertex_count = vertices.size() / m_stride;
+
+    // Grow geometrically, so that the cost of copying the old contents over
+    // is amortized across many allocations
+    std::optional<size_t> vertex_offset;
+    while(!(vertex_offset = m_vertex_allocator.allocate(allocation.vertex_count)))
+    {
+      size_t old_capacity = m_vertex_allocator.capacity();
+      size_t new_capacity = std::max(old_capacity * 2, old_capacity + allocation.vertex_count);
+      grow_buffer(m_vbo, old_capacity * m_stride, new_capacity * m_stride);
+      m_vertex_allocator.grow(new_capacity);
+      bind_buffers();
+    }
+
+    allocation.vertex_offset = *vertex_offset;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.vertex_offset * m_stride, vertices.size(), vertices.data());
+
+    return allocation;
+  }
+
+  void MeshArena::free(const Allocation& allocation)
+  {
+    if(allocation.vertex_count != 0)
+      m_vertex_allocator.free(allocation.vertex_offset);
+  }
+
+  void MeshArena::draw(std::span<const DrawElementsIndirectCommand> commands)
+  {
+    if(commands.empty())
+      return;
+
+    // Orphan the previous frame's commands instead of waiting for the GPU to
+    // be done with them
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_dbo);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size_bytes(), commands.data(), GL_STREAM_DRAW);
+
+    glBindVertexArray(m_vao);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, commands.size(), 0);
+  }
+}
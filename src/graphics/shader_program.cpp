@@ -1,7 +1,14 @@
 #include <graphics/shader_program.hpp>
 
+#include <spdlog/spdlog.h>
+
 #include <fstream>
 #include <sstream>
+#include <filesystem>
+#include <chrono>
+#include <vector>
+
+#include <cstdint>
 
 #include <glm/gtc/type_ptr.hpp>
 
@@ -9,7 +16,9 @@
 
 namespace graphics
 {
-  static GLuint compile_shader(GLenum type, const char *path)
+  static constexpr const char *PROGRAM_CACHE_DIRECTORY = ".cache/shaders";
+
+  static std::string read_file(const char *path)
   {
     std::ifstream     ifs;
     std::stringstream ss;
@@ -17,8 +26,11 @@ namespace graphics
     ifs.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     ifs.open(path);
     ss << ifs.rdbuf();
+    return ss.str();
+  }
 
-    std::string source = ss.str();
+  static GLuint compile_shader(GLenum type, const std::string& source)
+  {
     const GLchar *sources[] = { source.c_str() };
 
     GLuint shader = glCreateShader(type);
@@ -40,14 +52,15 @@ namespace graphics
     return shader;
   }
 
-  static GLuint link_program(const char* vertex_shader_path, const char *fragment_shader_path)
+  static GLuint link_program(const std::string& vertex_shader_source, const std::string& fragment_shader_source)
   {
-    GLuint vertex_shader   = compile_shader(GL_VERTEX_SHADER,   vertex_shader_path);   std::experimental::scope_exit vertex_shader_exit  ([vertex_shader]  (){ glDeleteShader(vertex_shader); });
-    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_shader_path); std::experimental::scope_exit fragment_shader_exit([fragment_shader](){ glDeleteShader(fragment_shader); });
+    GLuint vertex_shader   = compile_shader(GL_VERTEX_SHADER,   vertex_shader_source);   std::experimental::scope_exit vertex_shader_exit  ([vertex_shader]  (){ glDeleteShader(vertex_shader); });
+    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source); std::experimental::scope_exit fragment_shader_exit([fragment_shader](){ glDeleteShader(fragment_shader); });
 
     GLuint program = glCreateProgram();
     glAttachShader(program, vertex_shader);
     glAttachShader(program, fragment_shader);
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(program);
 
     GLint success;
@@ -62,10 +75,174 @@ namespace graphics
       throw std::runtime_error(std::move(message));
     }
 
+    glDetachShader(program, vertex_shader);
+    glDetachShader(program, fragment_shader);
+    return program;
+  }
+
+  /*****************
+   * Program cache *
+   *****************/
+  // Binaries are only valid for the exact driver that produced them, so the
+  // driver identity is part of the key along with both sources. A driver
+  // update that keeps the same strings is still caught when glProgramBinary
+  // fails, in which case the program is compiled again and the entry
+  // overwritten.
+  static std::filesystem::path program_cache_path(const std::string& vertex_shader_source, const std::string& fragment_shader_source)
+  {
+    // 64-bit FNV-1a
+    std::uint64_t hash = 0xcbf29ce484222325;
+    auto update = [&hash](std::string_view data) {
+      for(unsigned char c : data)
+      {
+        hash ^= c;
+        hash *= 0x100000001b3;
+      }
+      hash ^= 0xff; // Separator, so that moving bytes between fields changes the key
+      hash *= 0x100000001b3;
+    };
+
+    for(GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+    {
+      const GLubyte *string = glGetString(name);
+      update(string ? reinterpret_cast<const char*>(string) : "");
+    }
+    update(vertex_shader_source);
+    update(fragment_shader_source);
+
+    return std::filesystem::path(PROGRAM_CACHE_DIRECTORY) / fmt::format("{:016x}.bin", hash);
+  }
+
+  struct ProgramBinaryHeader
+  {
+    std::uint32_t format;
+    std::uint32_t length;
+  };
+
+  // Returns 0 if there is no usable binary
+  static GLuint load_program_binary(const std::filesystem::path& path)
+  {
+    std::ifstream ifs(path, std::ios::binary);
+    if(!ifs)
+      return 0;
+
+    std::error_code ec;
+    std::uintmax_t  file_size = std::filesystem::file_size(path, ec);
+    if(ec)
+      return 0;
+
+    ProgramBinaryHeader header;
+    if(!ifs.read(reinterpret_cast<char*>(&header), sizeof header))
+      return 0;
+
+    // The length comes from disk, so a truncated or corrupt file must not get
+    // to decide how much we allocate
+    if(file_size != sizeof header + std::uintmax_t(header.length))
+      return 0;
+
+    std::vector<char> binary(header.length);
+    if(!ifs.read(binary.data(), binary.size()))
+      return 0;
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), binary.size());
+
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if(!success)
+    {
+      glDeleteProgram(program);
+      return 0;
+    }
+
     return program;
   }
 
-  ShaderProgram::ShaderProgram(const char *vertex_shader_path, const char *fragment_shader_path) : m_id(link_program(vertex_shader_path, fragment_shader_path)) { }
+  static void store_program_binary(GLuint program, const std::filesystem::path& path)
+  {
+    GLint length;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length == 0)
+      return;
+
+    ProgramBinaryHeader header;
+    std::vector<char>   binary(length);
+    GLenum              format;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+    header.format = format;
+    header.length = length;
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    std::ofstream ofs(path, std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof header);
+    ofs.write(binary.data(), binary.size());
+    if(!ofs)
+      spdlog::warn("Failed to write program binary to {}", path.string());
+  }
+
+  static GLuint create_program(const char *vertex_shader_path, const char *fragment_shader_path)
+  {
+    auto begin = std::chrono::steady_clock::now();
+
+    std::string vertex_shader_source   = read_file(vertex_shader_path);
+    std::string fragment_shader_source = read_file(fragment_shader_path);
+
+    // Some drivers support the API without a single binary format
+    GLint format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+
+    std::filesystem::path path;
+    GLuint                program = 0;
+    if(format_count > 0)
+    {
+      path    = program_cache_path(vertex_shader_source, fragment_shader_source);
+      program = load_program_binary(path);
+    }
+
+    bool cached = program != 0;
+    if(!cached)
+    {
+      program = link_program(vertex_shader_source, fragment_shader_source);
+      if(format_count > 0)
+        store_program_binary(program, path);
+    }
+
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - begin;
+    spdlog::info("Shader program {} + {} {} in {:.2f} ms", vertex_shader_path, fragment_shader_path, cached ? "loaded from cache" : "compiled", duration.count());
+    return program;
+  }
+
+  ShaderProgram::ShaderProgram(const char *vertex_shader_path, const char *fragment_shader_path) : m_id(create_program(vertex_shader_path, fragment_shader_path))
+  {
+    GLint uniform_count, max_name_length;
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS,           &uniform_count);
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+    std::string name(max_name_length, '\0');
+    for(GLint i=0; i<uniform_count; ++i)
+    {
+      GLsizei length;
+      GLint   size;
+      GLenum  type;
+      glGetActiveUniform(m_id, i, name.size(), &length, &size, &type, name.data());
+
+      // Members of uniform blocks have no location, and are set through the
+      // block's buffer instead
+      std::string_view _name(name.data(), length);
+      GLint location = glGetUniformLocation(m_id, name.c_str());
+      if(location == -1)
+        continue;
+
+      // Arrays are reported as "name[0]", but are usually referred to by name
+      if(_name.ends_with("[0]"))
+        _name.remove_suffix(3);
+
+      m_uniform_locations.emplace(_name, location);
+    }
+  }
+
   ShaderProgram::~ShaderProgram() { glDeleteProgram(m_id); }
 
   void ShaderProgram::use() const
@@ -73,14 +250,21 @@ namespace graphics
     glUseProgram(m_id);
   }
 
-  void ShaderProgram::set_uniform(const char* name, float value) { glUniform1f(glGetUniformLocation(m_id, name), value); }
+  GLint ShaderProgram::uniform_location(std::string_view name) const
+  {
+    auto it = m_uniform_locations.find(name);
+    return it != m_uniform_locations.end() ? it->second : -1;
+  }
+
+  void ShaderProgram::set_uniform(GLint location, int   value) { glUniform1i(location, value); }
+  void ShaderProgram::set_uniform(GLint location, float value) { glUniform1f(location, value); }
 
-  void ShaderProgram::set_uniform(const char* name, glm::vec2 value) { glUniform2fv(glGetUniformLocation(m_id, name), 1, glm::value_ptr(value)); }
-  void ShaderProgram::set_uniform(const char* name, glm::vec3 value) { glUniform3fv(glGetUniformLocation(m_id, name), 1, glm::value_ptr(value)); }
-  void ShaderProgram::set_uniform(const char* name, glm::vec4 value) { glUniform4fv(glGetUniformLocation(m_id, name), 1, glm::value_ptr(value)); }
+  void ShaderProgram::set_uniform(GLint location, glm::vec2 value) { glUniform2fv(location, 1, glm::value_ptr(value)); }
+  void ShaderProgram::set_uniform(GLint location, glm::vec3 value) { glUniform3fv(location, 1, glm::value_ptr(value)); }
+  void ShaderProgram::set_uniform(GLint location, glm::vec4 value) { glUniform4fv(location, 1, glm::value_ptr(value)); }
 
-  void ShaderProgram::set_uniform(const char* name, glm::mat2 value) { glUniformMatrix2fv(glGetUniformLocation(m_id, name), 1, GL_FALSE, glm::value_ptr(value)); }
-  void ShaderProgram::set_uniform(const char* name, glm::mat3 value) { glUniformMatrix3fv(glGetUniformLocation(m_id, name), 1, GL_FALSE, glm::value_ptr(value)); }
-  void ShaderProgram::set_uniform(const char* name, glm::mat4 value) { glUniformMatrix4fv(glGetUniformLocation(m_id, name), 1, GL_FALSE, glm::value_ptr(value)); }
+  void ShaderProgram::set_uniform(GLint location, glm::mat2 value) { glUniformMatrix2fv(location, 1, GL_FALSE, glm::value_ptr(value)); }
+  void ShaderProgram::set_uniform(GLint location, glm::mat3 value) { glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value)); }
+  void ShaderProgram::set_uniform(GLint location, glm::mat4 value) { glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value)); }
 }
 
@@ -1,5 +1,7 @@
 #include <graphics/texture.hpp>
 
+#include <memory_registry.hpp>
+
 #include <stb_image.h>
 
 #include <experimental/scope>
@@ -19,7 +21,14 @@ namespace graphics
     return std::make_unique<Texture>(bytes, width, height, channels);
   }
 
+  static MemoryRegistry::Gauge& texture_memory()
+  {
+    static MemoryRegistry::Gauge& gauge = MemoryRegistry::instance().gauge("gpu.textures");
+    return gauge;
+  }
+
   Texture::Texture(unsigned char *bytes, unsigned width, unsigned height, unsigned channels)
+    : m_size(size_t(width) * height * channels)
   {
     glGenTextures(1, &m_id);
     glBindTexture(GL_TEXTURE_2D, m_id);
@@ -36,11 +45,13 @@ namespace graphics
       case 3: glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB,  width, height, 0, GL_RGB,  GL_UNSIGNED_BYTE, bytes); break;
       case 4: glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, bytes); break;
     }
+    texture_memory().add(m_size, 1);
   }
 
   Texture::~Texture()
   {
     glDeleteTextures(1, &m_id);
+    texture_memory().add(-static_cast<std::int64_t>(m_size), -1);
   }
 }
 
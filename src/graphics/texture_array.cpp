@@ -1,48 +1,291 @@
 #include <graphics/texture_array.hpp>
 
+#include <lazy.hpp>
+#include <memory_registry.hpp>
+
 #include <stb_image.h>
 
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#include <filesystem>
+#include <bit>
+#include <fstream>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+#include <string.h>
 #include <assert.h>
 
 namespace graphics
 {
-  TextureArray::TextureArray(const std::vector<std::string>& filenames)
+  struct Image
+  {
+    int                        width;
+    int                        height;
+    std::vector<unsigned char> bytes;
+    const char                *error; // Set instead of throwing on a worker
+  };
+
+  static Image decode_image(const std::string& filename)
+  {
+    // The global flag is not safe to touch from several workers at once
+    stbi_set_flip_vertically_on_load_thread(true);
+
+    Image image = {};
+    int channels_in_file;
+    stbi_uc *bytes = stbi_load(filename.c_str(), &image.width, &image.height, &channels_in_file, STBI_rgb_alpha);
+    if(!bytes)
+    {
+      image.error = stbi_failure_reason();
+      return image;
+    }
+
+    image.bytes.assign(&bytes[0], &bytes[image.width * image.height * 4]);
+    stbi_image_free(bytes);
+    return image;
+  }
+
+  // Box filter every layer of level-1 into level
+  static void generate_level(TextureArrayData& data, std::uint32_t level, size_t src_offset, size_t dst_offset)
+  {
+    std::uint32_t src_width  = data.level_width (level-1);
+    std::uint32_t src_height = data.level_height(level-1);
+    std::uint32_t dst_width  = data.level_width (level);
+    std::uint32_t dst_height = data.level_height(level);
+
+    for(std::uint32_t layer=0; layer<data.depth; ++layer)
+    {
+      const unsigned char *src = &data.bytes[src_offset + size_t(layer) * src_width * src_height * 4];
+      unsigned char       *dst = &data.bytes[dst_offset + size_t(layer) * dst_width * dst_height * 4];
+      for(std::uint32_t y=0; y<dst_height; ++y)
+        for(std::uint32_t x=0; x<dst_width; ++x)
+          for(std::uint32_t c=0; c<4; ++c)
+          {
+            // Dimensions of 1 are not halved any further
+            std::uint32_t x0 = std::min(2*x, src_width-1),  x1 = std::min(2*x+1, src_width-1);
+            std::uint32_t y0 = std::min(2*y, src_height-1), y1 = std::min(2*y+1, src_height-1);
+
+            unsigned sum = src[(y0 * src_width + x0) * 4 + c]
+                         + src[(y0 * src_width + x1) * 4 + c]
+                         + src[(y1 * src_width + x0) * 4 + c]
+                         + src[(y1 * src_width + x1) * 4 + c];
+            dst[(y * dst_width + x) * 4 + c] = (sum + 2) / 4;
+          }
+    }
+  }
+
+  TextureArrayData decode_texture_array(const std::vector<std::string>& filenames)
+  {
+    if(filenames.empty())
+      throw std::runtime_error("Texture array without any texture");
+
+    std::vector<std::unique_ptr<Lazy<Image>>> images;
+    for(const std::string& filename : filenames)
+      images.push_back(std::make_unique<Lazy<Image>>(TaskKind::ASSET_DECODE, [filename]() { return decode_image(filename); }));
+
+    for(size_t i=0; i<images.size(); ++i)
+      if(const char *error = images[i]->get().error)
+        throw std::runtime_error(fmt::format("Failed to load image {}: {}", filenames[i], error));
+
+    TextureArrayData data = {};
+    data.width  = images.front()->get().width;
+    data.height = images.front()->get().height;
+    data.depth  = filenames.size();
+
+    data.level_count = 1;
+    while((data.width | data.height) >> data.level_count)
+      ++data.level_count;
+
+    size_t size = 0;
+    for(std::uint32_t level=0; level<data.level_count; ++level)
+      size += data.level_size(level);
+    data.bytes.resize(size);
+
+    for(size_t i=0; i<images.size(); ++i)
+    {
+      const Image& image = images[i]->get();
+      if(image.width != static_cast<int>(data.width) || image.height != static_cast<int>(data.height))
+        throw std::runtime_error(fmt::format("Image {} is {}x{}, but the texture array is {}x{}", filenames[i], image.width, image.height, data.width, data.height));
+
+      memcpy(&data.bytes[i * image.bytes.size()], image.bytes.data(), image.bytes.size());
+    }
+
+    size_t offset = 0;
+    for(std::uint32_t level=1; level<data.level_count; ++level)
+    {
+      generate_level(data, level, offset, offset + data.level_size(level-1));
+      offset += data.level_size(level-1);
+    }
+
+    return data;
+  }
+
+  /***************
+   * Cooked cache *
+   ***************/
+  // Bump whenever the layout of TextureArrayData changes
+  static constexpr std::uint32_t TEXTURE_ARRAY_CACHE_MAGIC   = 0x41545856; // "VXTA"
+  static constexpr std::uint32_t TEXTURE_ARRAY_CACHE_VERSION = 1;
+
+  struct TextureArrayCacheHeader
+  {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t depth;
+    std::uint32_t level_count;
+  };
+
+  static std::filesystem::path texture_array_cache_path(const std::vector<std::string>& filenames)
+  {
+    // 64-bit FNV-1a
+    std::uint64_t hash = 0xcbf29ce484222325;
+    auto update = [&hash](const void *data, size_t size) {
+      for(size_t i=0; i<size; ++i)
+      {
+        hash ^= static_cast<const unsigned char*>(data)[i];
+        hash *= 0x100000001b3;
+      }
+    };
+
+    update(&TEXTURE_ARRAY_CACHE_VERSION, sizeof TEXTURE_ARRAY_CACHE_VERSION);
+    for(const std::string& filename : filenames)
+    {
+      std::uint64_t size  = std::filesystem::file_size(filename);
+      std::int64_t  mtime = std::filesystem::last_write_time(filename).time_since_epoch().count();
+      update(filename.c_str(), filename.size() + 1);
+      update(&size,  sizeof size);
+      update(&mtime, sizeof mtime);
+    }
+
+    return std::filesystem::path(TEXTURE_ARRAY_CACHE_DIRECTORY) / fmt::format("{:016x}.bin", hash);
+  }
+
+  static bool read_texture_array_cache(const std::filesystem::path& path, TextureArrayData& data)
+  {
+    std::ifstream ifs(path, std::ios::binary);
+    if(!ifs)
+      return false;
+
+    TextureArrayCacheHeader header;
+    if(!ifs.read(reinterpret_cast<char*>(&header), sizeof header))
+      return false;
+
+    if(header.magic != TEXTURE_ARRAY_CACHE_MAGIC || header.version != TEXTURE_ARRAY_CACHE_VERSION)
+      return false;
+
+    // The dimensions come from disk, so check them against what the file can
+    // actually hold before allocating anything. The first level is bounded
+    // before the size is computed, so that nothing overflows, and a mip chain
+    // can never be longer than the one built by decode_texture_array().
+    std::error_code ec;
+    std::uintmax_t  file_size = std::filesystem::file_size(path, ec);
+    if(ec || file_size < sizeof header)
+      return false;
+
+    std::uintmax_t texel_bytes = file_size - sizeof header;
+    std::uintmax_t layer_bytes = std::uintmax_t(header.width) * header.height * 4;
+    if(layer_bytes == 0 || header.depth == 0 || header.depth > texel_bytes / layer_bytes)
+      return false;
+
+    if(header.level_count == 0 || header.level_count > std::uint32_t(std::bit_width(header.width | header.height)))
+      return false;
+
+    data.width       = header.width;
+    data.height      = header.height;
+    data.depth       = header.depth;
+    data.level_count = header.level_count;
+
+    size_t size = 0;
+    for(std::uint32_t level=0; level<data.level_count; ++level)
+      size += data.level_size(level);
+
+    if(size != texel_bytes)
+      return false;
+
+    data.bytes.resize(size);
+    return static_cast<bool>(ifs.read(reinterpret_cast<char*>(data.bytes.data()), size));
+  }
+
+  static void write_texture_array_cache(const std::filesystem::path& path, const TextureArrayData& data)
+  {
+    TextureArrayCacheHeader header = {
+      .magic       = TEXTURE_ARRAY_CACHE_MAGIC,
+      .version     = TEXTURE_ARRAY_CACHE_VERSION,
+      .width       = data.width,
+      .height      = data.height,
+      .depth       = data.depth,
+      .level_count = data.level_count,
+    };
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    std::ofstream ofs(path, std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof header);
+    ofs.write(reinterpret_cast<const char*>(data.bytes.data()), data.bytes.size());
+    if(!ofs)
+      spdlog::warn("Failed to write texture array cache to {}", path.string());
+  }
+
+  TextureArrayData load_texture_array(const std::vector<std::string>& filenames)
+  {
+    auto begin = std::chrono::steady_clock::now();
+
+    TextureArrayData      data;
+    std::filesystem::path path   = texture_array_cache_path(filenames);
+    bool                  cached = read_texture_array_cache(path, data);
+    if(!cached)
+    {
+      data = decode_texture_array(filenames);
+      write_texture_array_cache(path, data);
+    }
+
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - begin;
+    spdlog::info("Texture array of {} layers {} in {:.2f} ms", data.depth, cached ? "loaded from cache" : "decoded", duration.count());
+    return data;
+  }
+
+  TextureArray::TextureArray(const std::vector<std::string>& filenames, bool use_cache)
+    : TextureArray(use_cache ? load_texture_array(filenames) : decode_texture_array(filenames))
+  {}
+
+  // Shared with plain textures
+  static MemoryRegistry::Gauge& texture_memory()
+  {
+    static MemoryRegistry::Gauge& gauge = MemoryRegistry::instance().gauge("gpu.textures");
+    return gauge;
+  }
+
+  TextureArray::TextureArray(const TextureArrayData& data)
+    : m_size(data.bytes.size())
   {
     glGenTextures(1, &m_id);
     glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
 
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S,     GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T,     GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    std::vector<stbi_uc> bytes;
-    int width  = 0;
-    int height = 0;
-    int depth  = filenames.size();
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, data.level_count, GL_RGBA8, data.width, data.height, data.depth);
 
-    stbi_set_flip_vertically_on_load(true);
-    for(const std::string& filename : filenames)
+    size_t offset = 0;
+    for(std::uint32_t level=0; level<data.level_count; ++level)
     {
-      int _width, _height, channels_in_file;
-      stbi_uc *_bytes = stbi_load(filename.c_str(), &_width, &_height, &channels_in_file, STBI_rgb_alpha);
-      assert(_bytes);
-      if(width  == 0) width  = _width;  else assert(width  == _width);
-      if(height == 0) height = _height; else assert(height == _height);
-      bytes.insert(bytes.end(), &_bytes[0], &_bytes[width * height * 4]);
-      stbi_image_free(_bytes);
+      glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, data.level_width(level), data.level_height(level), data.depth, GL_RGBA, GL_UNSIGNED_BYTE, &data.bytes[offset]);
+      offset += data.level_size(level);
     }
-    assert(width  != 0);
-    assert(height != 0);
-
-    assert(bytes.size() == width * height * depth * 4);
-
-    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, width, height, depth, 0, GL_RGBA, GL_UNSIGNED_BYTE, bytes.data());
+    assert(offset == data.bytes.size());
+    texture_memory().add(m_size, 1);
   }
 
   TextureArray::~TextureArray()
   {
     glDeleteTextures(1, &m_id);
+    texture_memory().add(-static_cast<std::int64_t>(m_size), -1);
   }
 }
-
@@ -0,0 +1,49 @@
+#include <graphics/ui_batch.hpp>
+
+#include <assert.h>
+
+namespace graphics
+{
+  void UIBatch::push_quad(const Texture& texture, glm::vec2 position, glm::vec2 dimension, glm::vec2 texture_min, glm::vec2 texture_max)
+  {
+    uint32_t index_base = m_vertices.size();
+    m_indices.push_back(index_base + 0);
+    m_indices.push_back(index_base + 1);
+    m_indices.push_back(index_base + 2);
+    m_indices.push_back(index_base + 2);
+    m_indices.push_back(index_base + 1);
+    m_indices.push_back(index_base + 3);
+
+    // Texture rows are stored top to bottom, while y goes up on screen
+    m_vertices.push_back(Vertex{ .position = position,                                 .tex_coords = glm::vec2(texture_min.x, texture_max.y), });
+    m_vertices.push_back(Vertex{ .position = position + glm::vec2(dimension.x, 0.0f), .tex_coords = glm::vec2(texture_max.x, texture_max.y), });
+    m_vertices.push_back(Vertex{ .position = position + glm::vec2(0.0f, dimension.y), .tex_coords = glm::vec2(texture_min.x, texture_min.y), });
+    m_vertices.push_back(Vertex{ .position = position + dimension,                     .tex_coords = glm::vec2(texture_max.x, texture_min.y), });
+
+    if(!m_runs.empty() && m_runs.back().texture == &texture)
+      m_runs.back().index_count += 6;
+    else
+      m_runs.push_back(Run{ .texture = &texture, .first_index = m_indices.size() - 6, .index_count = 6 });
+  }
+
+  void UIBatch::push_text(std::span<const Glyph> glyphs, const Texture& atlas, glm::vec2 position, std::string_view str)
+  {
+    for(char c : str)
+    {
+      size_t index = static_cast<unsigned char>(c);
+      assert(index < glyphs.size());
+
+      const Glyph& glyph = glyphs[index];
+      if(glyph.dimension.x != 0.0f && glyph.dimension.y != 0.0f)
+        push_quad(atlas, position + glyph.bearing, glyph.dimension, glyph.texture_min, glyph.texture_max);
+      position += glyph.advance;
+    }
+  }
+
+  void UIBatch::clear()
+  {
+    m_vertices.clear();
+    m_indices.clear();
+    m_runs.clear();
+  }
+}
@@ -8,48 +8,41 @@ namespace graphics
   {
     m_shader_program = std::make_unique<graphics::ShaderProgram>("./assets/ui.vert", "./assets/ui.frag");
 
-    struct Vertex
-    {
-      glm::vec2 position;
-      glm::vec2 tex_coords;
-    };
-
-    const uint8_t indices[] = { 0, 1, 2, 2, 1, 3 };
-    const Vertex vertices[] = {
-      { .position = glm::vec2(0.0f, 0.0f), .tex_coords = glm::vec2(0.0f, 1.0f), },
-      { .position = glm::vec2(1.0f, 0.0f), .tex_coords = glm::vec2(1.0f, 1.0f), },
-      { .position = glm::vec2(0.0f, 1.0f), .tex_coords = glm::vec2(0.0f, 0.0f), },
-      { .position = glm::vec2(1.0f, 1.0f), .tex_coords = glm::vec2(1.0f, 0.0f), },
-    };
-
     const Attribute attributes[] = {
-      { .type = graphics::AttributeType::FLOAT2, .offset = offsetof(Vertex, position),   },
-      { .type = graphics::AttributeType::FLOAT2, .offset = offsetof(Vertex, tex_coords), },
+      { .type = graphics::AttributeType::FLOAT2, .offset = offsetof(UIBatch::Vertex, position),   },
+      { .type = graphics::AttributeType::FLOAT2, .offset = offsetof(UIBatch::Vertex, tex_coords), },
     };
-    m_quad_mesh = std::make_unique<Mesh>(IndexType::UNSIGNED_BYTE, PrimitiveType::TRIANGLES, sizeof(Vertex), attributes);
-    m_quad_mesh->write(std::as_bytes(std::span(indices)), std::as_bytes(std::span(vertices)), Usage::STATIC);
+    m_batch_mesh = std::make_unique<Mesh>(IndexType::UNSIGNED_INT, PrimitiveType::TRIANGLES, sizeof(UIBatch::Vertex), attributes);
   }
 
-  void UIRenderer::render(glm::vec2 viewport, glm::vec2 position, glm::vec2 dimension, const graphics::Texture& texture)
+  void UIRenderer::render(glm::vec2 position, glm::vec2 dimension, const graphics::Texture& texture)
   {
-    glDisable(GL_DEPTH_TEST);
+    m_batch.push_quad(texture, position, dimension, glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f));
+  }
 
-    m_shader_program->use();
+  void UIRenderer::flush(glm::vec2 viewport)
+  {
+    if(m_batch.empty())
+      return;
 
-    glm::mat4 projection = glm::ortho(0.0f, (float)viewport.x, 0.0f, (float)viewport.y);
-    glm::mat4 view       = glm::mat4(1.0f);
+    glDisable(GL_DEPTH_TEST);
 
-    glm::mat4 model  = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(position .x, position .y, 0.0f));
-    model = glm::scale    (model, glm::vec3(dimension.x, dimension.y, 0.0f));
+    m_shader_program->use();
+    m_shader_program->set_uniform("MVP", glm::ortho(0.0f, (float)viewport.x, 0.0f, (float)viewport.y));
 
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture.id());
     m_shader_program->set_uniform("ourTexture", 0);
 
-    m_shader_program->set_uniform("MVP", projection * view * model);
-    m_quad_mesh->draw();
+    // Rewritten every frame, so stream it through the mesh's ring of buffers
+    m_batch_mesh->write(std::as_bytes(std::span(m_batch.indices())), std::as_bytes(std::span(m_batch.vertices())), Usage::STREAM);
+    for(const UIBatch::Run& run : m_batch.runs())
+    {
+      glBindTexture(GL_TEXTURE_2D, run.texture->id());
+      m_batch_mesh->draw(run.first_index, run.index_count);
+    }
 
     glEnable(GL_DEPTH_TEST);
+
+    m_batch.clear();
   }
 }
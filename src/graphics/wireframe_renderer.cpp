@@ -1,6 +1,6 @@
 #include <graphics/wireframe_renderer.hpp>
 
-#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
 
 namespace graphics
 {
@@ -39,23 +39,50 @@ namespace graphics
         attributes
     );
     m_cube_mesh->write(std::as_bytes(std::span(indices)), std::as_bytes(std::span(vertices)), Usage::STATIC);
+
+    const Attribute instance_attributes[] = {
+      { .type = graphics::AttributeType::FLOAT3, .offset = offsetof(Instance, position),  },
+      { .type = graphics::AttributeType::FLOAT3, .offset = offsetof(Instance, dimension), },
+      { .type = graphics::AttributeType::FLOAT3, .offset = offsetof(Instance, color),     },
+    };
+    m_cube_mesh->set_instance_layout(sizeof(Instance), instance_attributes);
+  }
+
+  void WireframeRenderer::render_cube(glm::vec3 position, glm::vec3 dimension, glm::vec3 color, float thickness)
+  {
+    m_instances.push_back(Instance{
+      .position  = position,
+      .dimension = dimension,
+      .color     = color,
+      .thickness = thickness,
+    });
   }
 
-  void WireframeRenderer::render_cube(const Camera& camera, glm::vec3 position, glm::vec3 dimension, glm::vec3 color, float thickness)
+  void WireframeRenderer::flush()
   {
-    glm::mat4 view       = camera.view();
-    glm::mat4 projection = camera.projection();
+    if(m_instances.empty())
+      return;
 
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, position);
-    model = glm::scale    (model, dimension);
+    // Group cubes of the same thickness together, so that each group is a
+    // contiguous range of instances
+    std::stable_sort(m_instances.begin(), m_instances.end(), [](const Instance& lhs, const Instance& rhs) {
+      return lhs.thickness < rhs.thickness;
+    });
+    m_cube_mesh->write_instances(std::as_bytes(std::span(m_instances)), Usage::STREAM);
 
     m_shader_program->use();
-    m_shader_program->set_uniform("MVP",   projection * view * model);
-    m_shader_program->set_uniform("color", color);
 
-    glLineWidth(thickness);
-    m_cube_mesh->draw();
+    for(size_t first = 0; first < m_instances.size();)
+    {
+      size_t last = first;
+      while(last < m_instances.size() && m_instances[last].thickness == m_instances[first].thickness)
+        ++last;
+
+      glLineWidth(m_instances[first].thickness);
+      m_cube_mesh->draw_instanced(first, last - first);
+      first = last;
+    }
+
+    m_instances.clear();
   }
 }
-
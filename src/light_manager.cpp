@@ -1,5 +1,8 @@
 #include <light_manager.hpp>
 
+#include <profiler.hpp>
+#include <memory_registry.hpp>
+
 void LightManager::invalidate(glm::ivec3 position)
 {
   m_invalidations.emplace(position, Invalidation{});
@@ -7,10 +10,18 @@ void LightManager::invalidate(glm::ivec3 position)
 
 void LightManager::update(World& world)
 {
+  PROFILE_ZONE("light_manager");
+
   std::unordered_set<glm::ivec3>               updates;
   std::unordered_map<glm::ivec3, Invalidation> new_invalidations;
+
+  // The invalidations are all consumed by the end of an update, so report
+  // the largest set of them we had to hold at once
+  size_t peak_invalidation_count = 0;
   while(!m_invalidations.empty())
   {
+    peak_invalidation_count = std::max(peak_invalidation_count, m_invalidations.size());
+
     /*************
      * 1: Update *
      *************/
@@ -91,6 +102,7 @@ end:
 
   for(glm::ivec3 update : updates)
   {
+    update_lod(world, update);
     invalidate_mesh(world, update + glm::ivec3(-1, 0, 0));
     invalidate_mesh(world, update + glm::ivec3( 1, 0, 0));
     invalidate_mesh(world, update + glm::ivec3(0, -1, 0));
@@ -98,5 +110,9 @@ end:
     invalidate_mesh(world, update + glm::ivec3(0, 0, -1));
     invalidate_mesh(world, update + glm::ivec3(0, 0,  1));
   }
+
+  using InvalidationEntry = decltype(m_invalidations)::value_type;
+  static MemoryRegistry::Gauge& invalidation_memory = MemoryRegistry::instance().gauge("light_manager.invalidations");
+  invalidation_memory.set(peak_invalidation_count * sizeof(InvalidationEntry), peak_invalidation_count);
 }
 
@@ -2,112 +2,156 @@
 
 #include <world_generator.hpp>
 #include <light_manager.hpp>
-#include <physics.hpp>
-#include <player_control.hpp>
 
 #include <graphics/camera.hpp>
 #include <graphics/ui_renderer.hpp>
 #include <graphics/window.hpp>
+#include <graphics/frame_uniforms.hpp>
 #include <graphics/wireframe_renderer.hpp>
 
-#include <timer.hpp>
+#include <simulation.hpp>
 
 #include <world_renderer.hpp>
 #include <debug_renderer.hpp>
 #include <player_ui.hpp>
 
 #include <resource_pack.hpp>
+#include <thread_pool.hpp>
+#include <profiler.hpp>
+#include <memory_registry.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <fstream>
+#include <mutex>
 
 int main()
 {
-  static constexpr float FIXED_DT = 1.0f / 20.0f;
-
   World world = load_world("world");
 
   WorldGenerator   world_generator(load_world_generation_config("world"));
   LightManager     light_manager;
 
-  graphics::Window            window("voxy", 1024, 720);
-  graphics::Camera            camera;
-  graphics::WireframeRenderer wireframer_renderer;
-  graphics::UIRenderer        ui_renderer;
+  graphics::Window             window("voxy", 1024, 720);
+  graphics::Camera             camera;
+  graphics::FrameUniformBuffer frame_uniform_buffer;
+  graphics::WireframeRenderer  wireframer_renderer;
+  graphics::UIRenderer         ui_renderer;
 
-  WorldRenderer world_renderer(load_resource_pack("resource_pack"));
+  WorldRenderer world_renderer(load_resource_pack("resource_pack"), world_generator.config());
   DebugRenderer debug_renderer;
 
   bool third_person = false;
   window.glfw_on_key([&third_person](int key, int scancode, int action, int mods) {
     if(key == GLFW_KEY_F5 && action == GLFW_PRESS)
       third_person = !third_person;
+
+    if(key == GLFW_KEY_F3 && action == GLFW_PRESS)
+    {
+      static constexpr const char *THREAD_POOL_STATS_PATH = "thread_pool_stats.json";
+      std::ofstream ofs(THREAD_POOL_STATS_PATH);
+      ThreadPool::instance().stats().dump_json(ofs);
+      spdlog::info("Thread pool stats dumped to {}", THREAD_POOL_STATS_PATH);
+    }
+
+    if(key == GLFW_KEY_F4 && action == GLFW_PRESS)
+    {
+      static constexpr const char *PROFILE_TRACE_PATH = "profile_trace.json";
+      std::ofstream ofs(PROFILE_TRACE_PATH);
+      Profiler::instance().dump_chrome_trace(ofs);
+      spdlog::info("Profile trace dumped to {}", PROFILE_TRACE_PATH);
+    }
   });
 
   bool   cursor_first = false;
   double cursor_xpos;
   double cursor_ypos;
 
-  Timer timer;
+  Simulation simulation(world, world_generator, light_manager);
+
+  // Memory usage is appended to a file every MEMORY_STATS_INTERVAL seconds,
+  // one line of JSON each, so that leaks show up over long sessions
+  static constexpr const char *MEMORY_STATS_PATH     = "memory_stats.jsonl";
+  static constexpr float       MEMORY_STATS_INTERVAL = 10.0f;
+  std::ofstream memory_stats(MEMORY_STATS_PATH);
+
+  Profiler::Clock::time_point frame_time        = Profiler::Clock::now();
+  Profiler::Clock::time_point start_time        = frame_time;
+  Profiler::Clock::time_point memory_stats_time = frame_time;
   for(;;)
   {
+    PROFILE_ZONE("frame");
+
+    Profiler::Clock::time_point new_frame_time = Profiler::Clock::now();
+    debug_renderer.update(std::chrono::duration<float>(new_frame_time - frame_time).count());
+    frame_time = new_frame_time;
+    Profiler::instance().end_frame();
+
+    if(std::chrono::duration<float>(frame_time - memory_stats_time).count() >= MEMORY_STATS_INTERVAL)
+    {
+      MemoryRegistry::instance().dump_json_line(memory_stats, std::chrono::duration<double>(frame_time - start_time).count());
+      memory_stats.flush();
+      memory_stats_time = frame_time;
+    }
+
     window.poll_events();
     if(window.should_close())
       return 0;
 
-    // 1: Update
-    if(timer.tick(FIXED_DT))
+    // 1: Input Handling
+    PlayerInput input = {};
+    input.key_space = window.get_key(GLFW_KEY_SPACE) == GLFW_PRESS;
+    input.key_w     = window.get_key(GLFW_KEY_W)     == GLFW_PRESS;
+    input.key_a     = window.get_key(GLFW_KEY_A)     == GLFW_PRESS;
+    input.key_s     = window.get_key(GLFW_KEY_S)     == GLFW_PRESS;
+    input.key_d     = window.get_key(GLFW_KEY_D)     == GLFW_PRESS;
+
+    input.mouse_button_left  = window.get_mouse_button(GLFW_MOUSE_BUTTON_LEFT)  == GLFW_PRESS;
+    input.mouse_button_right = window.get_mouse_button(GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
+
+    double new_cursor_xpos;
+    double new_cursor_ypos;
+    window.get_cursor_pos(new_cursor_xpos, new_cursor_ypos);
+    if(!cursor_first)
     {
-      // 1: Input Handling
-      world.players.front().key_space = window.get_key(GLFW_KEY_SPACE) == GLFW_PRESS;
-      world.players.front().key_w     = window.get_key(GLFW_KEY_W)     == GLFW_PRESS;
-      world.players.front().key_a     = window.get_key(GLFW_KEY_A)     == GLFW_PRESS;
-      world.players.front().key_s     = window.get_key(GLFW_KEY_S)     == GLFW_PRESS;
-      world.players.front().key_d     = window.get_key(GLFW_KEY_D)     == GLFW_PRESS;
-
-      world.players.front().mouse_button_left  = window.get_mouse_button(GLFW_MOUSE_BUTTON_LEFT)  == GLFW_PRESS;
-      world.players.front().mouse_button_right = window.get_mouse_button(GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
-
-      double new_cursor_xpos;
-      double new_cursor_ypos;
-      window.get_cursor_pos(new_cursor_xpos, new_cursor_ypos);
-      if(cursor_first)
-      {
-        world.players.front().cursor_motion_x = 0.0f;
-        world.players.front().cursor_motion_y = 0.0f;
-      }
-      else
-      {
-        world.players.front().cursor_motion_x = new_cursor_xpos - cursor_xpos;
-        world.players.front().cursor_motion_y = new_cursor_ypos - cursor_ypos;
-      }
-      cursor_xpos = new_cursor_xpos;
-      cursor_ypos = new_cursor_ypos;
-
-      // 2: Actual Update
-      world_generator.update(world, light_manager);
-      update_player_control(world, light_manager, FIXED_DT);
-      update_physics(world, FIXED_DT);
-      light_manager.update(world);
+      input.cursor_motion_x = new_cursor_xpos - cursor_xpos;
+      input.cursor_motion_y = new_cursor_ypos - cursor_ypos;
     }
+    cursor_xpos = new_cursor_xpos;
+    cursor_ypos = new_cursor_ypos;
+
+    simulation.push_input(input);
+
+    // 2: Rendering, one tick behind the simulation so that there are always
+    //    two snapshots to interpolate between
+    Simulation::Snapshots snapshots = simulation.snapshots();
+    RenderSnapshot        snapshot  = interpolate_render_snapshots(*snapshots.previous, *snapshots.current, snapshots.alpha(Simulation::Clock::now()));
 
-    // 2: Rendering
-    const Player& player        = world.players.front();
-    const Entity& player_entity = world.entities.at(player.entity_id);
-    camera.transform            =  player_entity.transform;
-    camera.transform.position.z += player_entity.eye;
+    camera.transform            =  snapshot.player().transform;
+    camera.transform.position.z += snapshot.player().eye;
     if(third_person)
-      camera.transform.position -= player_entity.transform.local_forward() * 5.0f;
+      camera.transform.position -= camera.transform.local_forward() * 5.0f;
 
     int width, height;
     window.get_framebuffer_size(width, height);
     camera.aspect = static_cast<float>(width) / static_cast<float>(height);
     camera.fovy   = 45.0f;
 
-    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClearColor(graphics::SKY_COLOR.x, graphics::SKY_COLOR.y, graphics::SKY_COLOR.z, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glViewport(0, 0, width, height);
 
-    world_renderer.render(camera, world, third_person, wireframer_renderer);
-    render_player_ui(camera, world, wireframer_renderer);
-    debug_renderer.render(glm::vec2(width, height), world, ui_renderer);
+    // Chunks to remesh are only copied out of the world while the simulation
+    // is between ticks, so that a slow tick never holds up a frame, and the
+    // meshing itself never holds up a tick
+    if(std::unique_lock lock(simulation.world_mutex(), std::try_to_lock); lock)
+      world_renderer.update(camera, world);
+
+    frame_uniform_buffer.update(camera);
+    world_renderer.render(camera, snapshot, third_person, wireframer_renderer);
+    render_player_ui(snapshot, wireframer_renderer);
+    wireframer_renderer.flush();
+    debug_renderer.render(glm::vec2(width, height), snapshot, snapshots.tick_stats, world_renderer.stats(), ui_renderer);
 
     window.swap_buffers();
   }
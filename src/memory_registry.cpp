@@ -0,0 +1,34 @@
+#include <memory_registry.hpp>
+
+MemoryRegistry& MemoryRegistry::instance()
+{
+  static MemoryRegistry registry;
+  return registry;
+}
+
+MemoryRegistry::Gauge& MemoryRegistry::gauge(const std::string& name)
+{
+  std::lock_guard guard(m_mutex);
+  std::unique_ptr<Gauge>& gauge = m_gauges[name];
+  if(!gauge)
+    gauge = std::make_unique<Gauge>();
+  return *gauge;
+}
+
+std::vector<MemoryRegistry::Entry> MemoryRegistry::entries() const
+{
+  std::lock_guard guard(m_mutex);
+
+  std::vector<Entry> entries;
+  for(const auto& [name, gauge] : m_gauges)
+    entries.push_back(Entry{ .name = name, .bytes = gauge->bytes(), .count = gauge->count() });
+  return entries;
+}
+
+void MemoryRegistry::dump_json_line(std::ostream& os, double time) const
+{
+  os << "{\"time\":" << time;
+  for(const Entry& entry : entries())
+    os << ",\"" << entry.name << "\":{\"bytes\":" << entry.bytes << ",\"count\":" << entry.count << '}';
+  os << "}\n";
+}
@@ -1,11 +1,23 @@
 #include <physics.hpp>
 
+#include <coordinates.hpp>
+#include <profiler.hpp>
+
 #include <optional>
 
 static constexpr float FRICTION_AIR      = 0.03f;
 static constexpr float FRICTION_GROUNDED = 0.05f;
 static constexpr float GRAVITY           = 9.8f;
 
+// Overlapping entities are gently pushed apart horizontally
+static constexpr float ENTITY_PUSH_STRENGTH = 4.0f;
+
+// A grounded entity moving slower than this for SLEEP_TICKS consecutive ticks
+// is put to sleep. An entity in the air gains far more than this from gravity
+// in a single tick, so only entities actually held up by a block qualify.
+static constexpr float        SLEEP_VELOCITY = 0.05f;
+static constexpr std::uint8_t SLEEP_TICKS    = 30;
+
 struct SweptAABBResult
 {
   float t_in;  glm::vec3 normal_in;
@@ -56,14 +68,71 @@ static std::optional<SweptAABBResult> swept_aabb(AABB box1, AABB box2, glm::vec3
   return result;
 }
 
-static void entity_update_physics(const World& world, Entity& entity, float dt)
+// Solid voxels overlapping the swept bounding box are gathered into a fixed
+// buffer on the stack. This comfortably covers an entity falling at terminal
+// velocity. Anything larger is walked directly in the world instead.
+static constexpr size_t MAX_COLLISION_CANDIDATES = 512;
+
+template<typename F>
+static void for_each_solid_block(const World& world, glm::ivec3 corner_min, glm::ivec3 corner_max, F f)
+{
+  int z_min = std::max(corner_min.z, 0);
+  int z_max = std::min(corner_max.z, CHUNK_HEIGHT - 1);
+  for(int y = corner_min.y; y<=corner_max.y; ++y)
+    for(int x = corner_min.x; x<=corner_max.x; ++x)
+    {
+      // Only look up the chunk once per column
+      auto [local_position, chunk_index] = coordinates::split(glm::ivec3(x, y, 0));
+      auto it = world.chunks.find(chunk_index);
+      if(it == world.chunks.end())
+        continue;
+
+      const Chunk& chunk = it->second;
+      for(int z = z_min; z<=z_max; ++z)
+        if(chunk.blocks[z][local_position.y][local_position.x].id != BLOCK_ID_NONE)
+          f(glm::ivec3(x, y, z));
+    }
+}
+
+// Friction and gravity only touch the velocity and grounded arrays, so this
+// is kept as a separate flat loop that the compiler can vectorize. Sleeping
+// entities have zero velocity, so masking out gravity is enough to leave them
+// untouched without introducing a branch.
+static void integrate_forces(Entities::Physics& physics, float dt)
+{
+  const size_t count = physics.velocities.size();
+#pragma omp simd
+  for(size_t i=0; i<count; ++i)
+  {
+    float friction = physics.grounded[i] ? FRICTION_GROUNDED : FRICTION_AIR;
+    float awake    = physics.sleeping[i] ? 0.0f : 1.0f;
+    physics.velocities[i]   -= (dt * friction) * physics.velocities[i];
+    physics.velocities[i].z -= awake * dt * GRAVITY;
+  }
+}
+
+static void entity_update_sleep(Entities::Physics& physics, size_t index)
 {
-  float friction = entity.grounded ? FRICTION_GROUNDED : FRICTION_AIR;
-  entity_apply_force(entity, -friction * entity.velocity,        dt);
-  entity_apply_force(entity, -GRAVITY  * glm::vec3(0.0f, 0.0f, 1.0f), dt);
+  glm::vec3 velocity = physics.velocities[index];
+  if(!physics.grounded[index] || glm::dot(velocity, velocity) >= SLEEP_VELOCITY * SLEEP_VELOCITY)
+  {
+    physics.idle_ticks[index] = 0;
+    return;
+  }
+
+  if(++physics.idle_ticks[index] >= SLEEP_TICKS)
+  {
+    physics.velocities[index] = glm::vec3(0.0f);
+    physics.sleeping[index]   = true;
+  }
+}
 
-  AABB entity_aabb = entity_get_aabb(entity);
-  glm::vec3 direction = dt * entity.velocity;
+static void entity_resolve_collisions(const World& world, Entities::Physics& physics, size_t index, float dt)
+{
+  AABB entity_aabb = entity_get_aabb(world.entities, index);
+  glm::vec3 direction = dt * physics.velocities[index];
+  if(direction == glm::vec3(0.0f))
+    return;
 
   glm::vec3 corner1 = entity_aabb.position                                    ;
   glm::vec3 corner2 = entity_aabb.position                         + direction;
@@ -73,50 +142,118 @@ static void entity_update_physics(const World& world, Entity& entity, float dt)
   glm::ivec3 corner_min = glm::floor(glm::min(glm::min(glm::min(corner1, corner2), corner3), corner4));
   glm::ivec3 corner_max = glm::ceil (glm::max(glm::max(glm::max(corner1, corner2), corner3), corner4));
 
-  struct Item
-  {
-    glm::ivec3 position;
-    float      distance;
+  glm::ivec3 extent = corner_max - corner_min + glm::ivec3(1);
+  size_t     volume = static_cast<size_t>(extent.x) * static_cast<size_t>(extent.y) * static_cast<size_t>(extent.z);
+
+  glm::ivec3 candidates[MAX_COLLISION_CANDIDATES];
+  size_t     candidate_count = 0;
+  if(volume <= MAX_COLLISION_CANDIDATES)
+    for_each_solid_block(world, corner_min, corner_max, [&](glm::ivec3 position) { candidates[candidate_count++] = position; });
+
+  auto for_each_candidate = [&](auto f) {
+    if(volume <= MAX_COLLISION_CANDIDATES)
+      for(size_t i=0; i<candidate_count; ++i)
+        f(candidates[i]);
+    else
+      for_each_solid_block(world, corner_min, corner_max, f);
   };
-  std::vector<Item> items;
-
-  // We store all voxel that may be in our path and sort them by distance.
-  // The idea comes from the video - Arbitrary Rectangle Collision Detection &
-  // Resolution - Complete! by javidx9 at
-  // https://www.youtube.com/watch?v=8JJ-4JgR7Dg.
-  for(int z = corner_min.z; z<=corner_max.z; ++z)
-    for(int y = corner_min.y; y<=corner_max.y; ++y)
-      for(int x = corner_min.x; x<=corner_max.x; ++x)
-        items.push_back(Item{
-          .position = glm::ivec3(x, y, z),
-          .distance = glm::length(glm::vec3(x, y, z) - entity.transform.position),
-        });
-
-  std::sort(items.begin(), items.end(), [](const Item& lhs, const Item& rhs) { return lhs.distance < rhs.distance; });
-
-  for(const Item& item : items)
+
+  // Resolve collisions in time-of-impact order. Once we hit something along
+  // an axis, the motion along that axis is clipped to the point of contact,
+  // so every later hit on the same axis would happen at t = 1 and change
+  // nothing. This means there are at most three hits that matter.
+  bool axis_resolved[3] = {};
+  for(int pass=0; pass<3; ++pass)
   {
-    if(const Block* block = get_block(world, item.position); block && block->id != BLOCK_ID_NONE)
-    {
-      AABB block_aabb  = { .position = item.position,             .dimension = glm::vec3(1.0f),     };
+    std::optional<SweptAABBResult> first_hit;
+    int                            first_hit_axis = 0;
+    for_each_candidate([&](glm::ivec3 position) {
+      AABB block_aabb  = { .position = position, .dimension = glm::vec3(1.0f), };
       if(std::optional<SweptAABBResult> result = swept_aabb(entity_aabb, block_aabb, direction))
         if(0.0f <= result->t_in && result->t_in <= 1.0f)
         {
-          direction       -= glm::dot(direction,       result->normal_in) * result->normal_in * (1.0f - result->t_in);
-          entity.velocity -= glm::dot(entity.velocity, result->normal_in) * result->normal_in;
-
-          entity.collided = true;
-          if(result->normal_in.z > 0.0f)
-            entity.grounded = true;
+          int axis = result->normal_in.x != 0.0f ? 0 : result->normal_in.y != 0.0f ? 1 : 2;
+          if(!axis_resolved[axis] && (!first_hit || result->t_in < first_hit->t_in))
+          {
+            first_hit      = result;
+            first_hit_axis = axis;
+          }
         }
-    }
+    });
+
+    if(!first_hit)
+      break;
+
+    glm::vec3& velocity = physics.velocities[index];
+    direction -= glm::dot(direction, first_hit->normal_in) * first_hit->normal_in * (1.0f - first_hit->t_in);
+    velocity  -= glm::dot(velocity,  first_hit->normal_in) * first_hit->normal_in;
+
+    physics.collided[index] = true;
+    if(first_hit->normal_in.z > 0.0f)
+      physics.grounded[index] = true;
+
+    axis_resolved[first_hit_axis] = true;
   }
 
-  entity.transform.position += direction;
+  physics.positions[index] += direction;
+}
+
+static void entities_push_apart(Entities& entities, size_t index1, size_t index2, float dt)
+{
+  glm::vec3 direction = entities.physics.positions[index2] - entities.physics.positions[index1];
+  direction.z = 0.0f;
+  if(direction == glm::vec3(0.0f))
+    direction = glm::vec3(1.0f, 0.0f, 0.0f);
+
+  direction = glm::normalize(direction);
+  entity_apply_force(entities, index1, -ENTITY_PUSH_STRENGTH * direction, dt);
+  entity_apply_force(entities, index2, +ENTITY_PUSH_STRENGTH * direction, dt);
 }
 
 void update_physics(World& world, float dt)
 {
-  for(Entity& entity : world.entities)
-    entity_update_physics(world, entity, dt);
+  PROFILE_ZONE("physics");
+
+  Entities::Physics& physics = world.entities.physics;
+  integrate_forces(physics, dt);
+
+  // Voxel collision is by far the most expensive part of a tick, so only run
+  // it for entities that are awake
+  const size_t count = world.entities.size();
+
+  std::vector<std::uint32_t> awake;
+  awake.reserve(count);
+  for(size_t i=0; i<count; ++i)
+    if(!physics.sleeping[i])
+      awake.push_back(i);
+
+  // Each entity only reads the world and writes to itself, so the result does
+  // not depend on how entities are split across threads. Starting the team
+  // costs microseconds, which is not worth a threshold, see
+  // bench/physics_stress.cpp.
+  const size_t awake_count = awake.size();
+#pragma omp parallel for schedule(static)
+  for(size_t i=0; i<awake_count; ++i)
+  {
+    entity_resolve_collisions(world, physics, awake[i], dt);
+    entity_update_sleep(physics, awake[i]);
+  }
+
+  // Nothing has moved if everything is asleep. Entities are created awake, so
+  // the only way the hash can be stale here is if some were destroyed.
+  if(awake_count == 0 && world.entity_hash.size() == count)
+    return;
+
+  // Broadphase for entity-entity interactions. Pairs come out sorted, so the
+  // order in which the pushes are applied is deterministic.
+  std::vector<AABB> aabbs;
+  aabbs.reserve(count);
+  for(size_t i=0; i<count; ++i)
+    aabbs.push_back(entity_get_aabb(world.entities, i));
+  world.entity_hash.rebuild(aabbs);
+
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> pairs;
+  world.entity_hash.query_pairs(pairs);
+  for(auto [i, j] : pairs)
+    entities_push_apart(world.entities, i, j, dt);
 }
@@ -1,5 +1,6 @@
 #include <player_control.hpp>
 
+#include <aabb.hpp>
 #include <directions.hpp>
 #include <ray_cast.hpp>
 
@@ -11,74 +12,100 @@ static constexpr float JUMP_STRENGTH = 5.0f;
 static constexpr float RAY_CAST_LENGTH = 20.0f;
 static constexpr float ACTION_COOLDOWN = 0.1f;
 
-static bool aabb_collide(glm::vec3 position1, glm::vec3 dimension1, glm::vec3 position2, glm::vec3 dimension2)
+// Cast the rays of all players in one batch, since they are usually looking
+// at the same few chunks
+static void update_player_selections(World& world)
 {
-  glm::vec3 min = glm::max(position1,            position2);
-  glm::vec3 max = glm::min(position1+dimension1, position2+dimension2);
-  for(int i=0; i<3; ++i)
-    if(min[i] >= max[i])
-      return false;
-  return true;
+  std::vector<Ray> rays;
+  rays.reserve(world.players.size());
+  for(const Player& player : world.players)
+  {
+    size_t    index     = world.entities.index(player.entity);
+    Transform transform = world.entities.transform(index);
+    rays.push_back(Ray{ .position = transform.position + glm::vec3(0.0f, 0.0f, world.entities.transforms.eyes[index]), .direction = transform.local_forward(), .length = RAY_CAST_LENGTH });
+  }
+
+  std::vector<RayCastBlocksResult> ray_cast_results(rays.size());
+  ray_cast_blocks(world, rays, ray_cast_results);
+
+  for(size_t i=0; i<world.players.size(); ++i)
+  {
+    Player&                    player          = world.players[i];
+    const RayCastBlocksResult& ray_cast_result = ray_cast_results[i];
+    switch(ray_cast_result.type)
+    {
+    case RayCastBlocksResult::Type::INSIDE_BLOCK:
+      player.selection = ray_cast_result.position;
+      player.placement = std::nullopt;
+      break;
+    case RayCastBlocksResult::Type::HIT:
+      player.selection = ray_cast_result.position;
+      player.placement = ray_cast_result.position + ray_cast_result.normal;
+      break;
+    case RayCastBlocksResult::Type::NONE:
+      player.selection = std::nullopt;
+      player.placement = std::nullopt;
+      break;
+    }
+  }
 }
 
 void update_player_control(World& world, LightManager& light_manager, float dt)
 {
   for(Player& player : world.players)
   {
-    Entity& player_entity = world.entities.at(player.entity_id);
+    Entities& entities = world.entities;
+    size_t    index    = entities.index(player.entity);
 
     // 1: Jump
     if(player.key_space)
-      if(player_entity.grounded)
+      if(entities.physics.grounded[index])
       {
-        player_entity.grounded = false;
-        entity_apply_impulse(player_entity, JUMP_STRENGTH * glm::vec3(0.0f, 0.0f, 1.0f));
+        entities.physics.grounded[index] = false;
+        entity_apply_impulse(entities, index, JUMP_STRENGTH * glm::vec3(0.0f, 0.0f, 1.0f));
       }
 
     // 2: Movement
+    Transform transform = entities.transform(index);
+
     glm::vec3 translation = glm::vec3(0.0f);
-    if(player.key_d) translation += player_entity.transform.local_right();
-    if(player.key_a) translation -= player_entity.transform.local_right();
-    if(player.key_w) translation += player_entity.transform.local_forward();
-    if(player.key_s) translation -= player_entity.transform.local_forward();
+    if(player.key_d) translation += transform.local_right();
+    if(player.key_a) translation -= transform.local_right();
+    if(player.key_w) translation += transform.local_forward();
+    if(player.key_s) translation -= transform.local_forward();
 
     if(glm::vec3 direction = translation; direction.z = 0.0f, glm::length(direction) != 0.0f)
-      entity_apply_force(player_entity, MOVEMENT_SPEED * glm::normalize(direction), dt);
-    else if(glm::vec3 direction = -player_entity.velocity; direction.z = 0.0f, glm::length(direction) != 0.0f)
-      entity_apply_force(player_entity, MOVEMENT_SPEED * glm::normalize(direction), dt, glm::length(direction));
+      entity_apply_force(entities, index, MOVEMENT_SPEED * glm::normalize(direction), dt);
+    else if(glm::vec3 direction = -entities.physics.velocities[index]; direction.z = 0.0f, glm::length(direction) != 0.0f)
+      entity_apply_force(entities, index, MOVEMENT_SPEED * glm::normalize(direction), dt, glm::length(direction));
 
     // 3: Rotation
-    player_entity.transform = player_entity.transform.rotate(glm::vec3(0.0f,
+    transform = transform.rotate(glm::vec3(0.0f,
       -player.cursor_motion_y * ROTATION_SPEED,
       -player.cursor_motion_x * ROTATION_SPEED
     ));
+    entities.set_transform(index, transform);
+  }
 
-    // 4: Block placement/destruction
-    player.cooldown = std::max(player.cooldown - dt, 0.0f);
+  // 4: Block placement/destruction. Selections are cast before anyone edits
+  //    anything, so an edit by one player may leave the selection of another
+  //    one block out of date until the end of the tick. That is harmless, as
+  //    every edit checks the block it is about to change.
+  update_player_selections(world);
 
-    RayCastBlocksResult ray_cast_result = ray_cast_blocks(world, player_entity.transform.position + glm::vec3(0.0f, 0.0f, player_entity.eye), player_entity.transform.local_forward(), RAY_CAST_LENGTH);
+  bool edited = false;
+  for(Player& player : world.players)
+  {
+    Entities& entities  = world.entities;
+    size_t    index     = entities.index(player.entity);
+    Transform transform = entities.transform(index);
 
-    std::optional<glm::ivec3> selection, placement;
-    switch(ray_cast_result.type)
-    {
-    case RayCastBlocksResult::Type::INSIDE_BLOCK:
-      selection = ray_cast_result.position;
-      placement = std::nullopt;
-      break;
-    case RayCastBlocksResult::Type::HIT:
-      selection = ray_cast_result.position;
-      placement = ray_cast_result.position + ray_cast_result.normal;
-      break;
-    case RayCastBlocksResult::Type::NONE:
-      selection = std::nullopt;
-      placement = std::nullopt;
-      break;
-    }
+    player.cooldown = std::max(player.cooldown - dt, 0.0f);
 
     if(player.cooldown == 0.0f)
       if(player.mouse_button_left)
-        if(selection)
-          if(Block *block = get_block(world, *selection))
+        if(player.selection)
+          if(Block *block = get_block(world, *player.selection))
             if(block->id != BLOCK_ID_NONE)
             {
               if(block->destroy_level != 15)
@@ -86,33 +113,44 @@ void update_player_control(World& world, LightManager& light_manager, float dt)
               else
                 block->id = BLOCK_ID_NONE;
 
-              invalidate_mesh(world, *selection);
-              light_manager.invalidate(*selection);
+              update_occupancy(world, *player.selection);
+              update_lod(world, *player.selection);
+              invalidate_mesh(world, *player.selection);
+              light_manager.invalidate(*player.selection);
+              wake_entities(world, *player.selection);
               for(glm::ivec3 direction : DIRECTIONS)
               {
-                glm::ivec3 neighbour_position = *selection + direction;
+                glm::ivec3 neighbour_position = *player.selection + direction;
                 invalidate_mesh(world, neighbour_position);
               }
               player.cooldown = ACTION_COOLDOWN;
+              edited = true;
             }
 
     if(player.cooldown == 0.0f)
       if(player.mouse_button_right)
-        if(placement)
-          if(Block *block = get_block(world, *placement))
+        if(player.placement)
+          if(Block *block = get_block(world, *player.placement))
             if(block->id == BLOCK_ID_NONE)
-              if(!aabb_collide(player_entity.transform.position, player_entity.dimension, *placement, glm::vec3(1.0f, 1.0f, 1.0f))) // Cannot place a block that collide with the player
+              if(!aabb_overlap(AABB{transform.position, entities.physics.dimensions[index]}, AABB{*player.placement, glm::vec3(1.0f, 1.0f, 1.0f)})) // Cannot place a block that collide with the player
               {
                 block->id = BLOCK_ID_STONE;
-                invalidate_mesh(world, *placement);
-                light_manager.invalidate(*placement);
+                update_occupancy(world, *player.placement);
+                update_lod(world, *player.placement);
+                invalidate_mesh(world, *player.placement);
+                light_manager.invalidate(*player.placement);
+                wake_entities(world, *player.placement);
                 for(glm::ivec3 direction : DIRECTIONS)
                 {
-                  glm::ivec3 neighbour_position = *placement + direction;
+                  glm::ivec3 neighbour_position = *player.placement + direction;
                   invalidate_mesh(world, neighbour_position);
                 }
                 player.cooldown = ACTION_COOLDOWN;
+                edited = true;
               }
   }
+
+  if(edited)
+    update_player_selections(world);
 }
 
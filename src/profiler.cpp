@@ -0,0 +1,120 @@
+#include <profiler.hpp>
+
+#include <algorithm>
+
+Profiler& Profiler::instance()
+{
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Profiler() : m_start_time(Clock::now()), m_totals_time(Clock::now()) {}
+
+Profiler::ThreadRing& Profiler::thread_ring()
+{
+  // Rings are owned by the profiler and outlive their threads, so that the
+  // zones of finished threads still show up in traces
+  thread_local ThreadRing *ring = nullptr;
+  if(!ring)
+  {
+    std::lock_guard guard(m_mutex);
+    auto new_ring = std::make_unique<ThreadRing>();
+    new_ring->thread_index = m_rings.size();
+    new_ring->zones.resize(RING_CAPACITY);
+    new_ring->head    = 0;
+    new_ring->drained = 0;
+    ring = new_ring.get();
+    m_rings.push_back(std::move(new_ring));
+  }
+  return *ring;
+}
+
+void Profiler::record(const char *name, Clock::time_point begin, Clock::time_point end)
+{
+  ThreadRing& ring = thread_ring();
+  std::lock_guard guard(ring.mutex);
+  ring.zones[ring.head % RING_CAPACITY] = Zone{ .name = name, .begin = begin, .end = end };
+  ++ring.head;
+}
+
+void Profiler::end_frame()
+{
+  std::lock_guard guard(m_mutex);
+  for(const std::unique_ptr<ThreadRing>& ring : m_rings)
+  {
+    std::lock_guard ring_guard(ring->mutex);
+
+    // Zones overwritten before being drained are lost for the averages
+    std::uint64_t first = std::max(ring->drained, ring->head > RING_CAPACITY ? ring->head - RING_CAPACITY : 0);
+    for(std::uint64_t i=first; i<ring->head; ++i)
+    {
+      const Zone& zone = ring->zones[i % RING_CAPACITY];
+
+      // There are only a handful of distinct zones
+      auto it = std::find_if(m_totals.begin(), m_totals.end(), [&](const ZoneTotal& total) { return total.name == zone.name; });
+      if(it == m_totals.end())
+        it = m_totals.insert(m_totals.end(), ZoneTotal{ .name = zone.name, .count = 0, .total = {}, .max = {} });
+
+      Clock::duration duration = zone.end - zone.begin;
+      ++it->count;
+      it->total += duration;
+      it->max    = std::max(it->max, duration);
+    }
+    ring->drained = ring->head;
+  }
+
+  Clock::time_point now     = Clock::now();
+  float             elapsed = std::chrono::duration<float>(now - m_totals_time).count();
+  if(elapsed < AVERAGE_INTERVAL)
+    return;
+
+  m_averages.clear();
+  for(ZoneTotal& total : m_totals)
+  {
+    if(total.count == 0)
+      continue;
+
+    using Microseconds = std::chrono::duration<float, std::micro>;
+    m_averages.push_back(ZoneAverage{
+      .name             = total.name,
+      .average_us       = Microseconds(total.total).count() / total.count,
+      .max_us           = Microseconds(total.max).count(),
+      .count_per_second = total.count / elapsed,
+    });
+    total.count = 0;
+    total.total = {};
+    total.max   = {};
+  }
+  std::sort(m_averages.begin(), m_averages.end(), [](const ZoneAverage& lhs, const ZoneAverage& rhs) {
+    return lhs.average_us * lhs.count_per_second > rhs.average_us * rhs.count_per_second;
+  });
+  m_totals_time = now;
+}
+
+void Profiler::dump_chrome_trace(std::ostream& os) const
+{
+  using Microseconds = std::chrono::duration<double, std::micro>;
+
+  std::lock_guard guard(m_mutex);
+  os << "{\"traceEvents\":[";
+
+  bool first = true;
+  for(const std::unique_ptr<ThreadRing>& ring : m_rings)
+  {
+    std::lock_guard ring_guard(ring->mutex);
+    for(std::uint64_t i = ring->head > RING_CAPACITY ? ring->head - RING_CAPACITY : 0; i<ring->head; ++i)
+    {
+      const Zone& zone = ring->zones[i % RING_CAPACITY];
+      if(!first)
+        os << ',';
+      first = false;
+
+      // Zone names are identifiers, nothing in them needs escaping
+      os << "{\"name\":\"" << zone.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << ring->thread_index
+         << ",\"ts\":"  << Microseconds(zone.begin - m_start_time).count()
+         << ",\"dur\":" << Microseconds(zone.end - zone.begin).count() << '}';
+    }
+  }
+
+  os << "]}\n";
+}
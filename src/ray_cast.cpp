@@ -1,83 +1,238 @@
 #include <ray_cast.hpp>
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <coordinates.hpp>
 
-RayCastBlocksResult ray_cast_blocks(const World& world, glm::vec3 position, glm::vec3 direction, float length)
+#include <optional>
+
+#include <assert.h>
+
+// Block lookups along a ray are almost always in the same chunk as the
+// previous one, so we remember the last chunk and only go through the chunk
+// map when we cross into another one.
+class ChunkCache
+{
+public:
+  ChunkCache(const World& world) : m_world(world), m_chunk_index(), m_chunk(nullptr), m_valid(false) {}
+
+public:
+  const Chunk *get_chunk(glm::ivec2 chunk_index)
+  {
+    if(!m_valid || m_chunk_index != chunk_index)
+    {
+      auto it = m_world.chunks.find(chunk_index);
+      m_chunk_index = chunk_index;
+      m_chunk       = it != m_world.chunks.end() ? &it->second : nullptr;
+      m_valid       = true;
+    }
+    return m_chunk;
+  }
+
+  const Block *get_block(glm::ivec3 position)
+  {
+    if(position.z < 0 || position.z >= CHUNK_HEIGHT)
+      return nullptr;
+
+    auto [local_position, chunk_index] = coordinates::split(position);
+    if(!m_valid || m_chunk_index != chunk_index)
+    {
+      auto it = m_world.chunks.find(chunk_index);
+      m_chunk_index = chunk_index;
+      m_chunk       = it != m_world.chunks.end() ? &it->second : nullptr;
+      m_valid       = true;
+    }
+    return m_chunk ? &m_chunk->blocks[local_position.z][local_position.y][local_position.x] : nullptr;
+  }
+
+private:
+  const World& m_world;
+  glm::ivec2   m_chunk_index;
+  const Chunk *m_chunk;
+  bool         m_valid;
+};
+
+// Axis-aligned region of the world that a ray can skip over entirely because
+// it is known to be empty
+struct EmptyRegion
+{
+  glm::ivec3 origin;
+  glm::ivec3 dimension;
+};
+
+// Find the largest region around position that we can cheaply tell is empty:
+// anything above or below the world, a missing chunk or an empty section.
+static std::optional<EmptyRegion> find_empty_region(ChunkCache& cache, glm::ivec3 position)
+{
+  if(position.z < 0 || position.z >= CHUNK_HEIGHT)
+    return EmptyRegion{ .origin = position, .dimension = glm::ivec3(1) };
+
+  auto [local_position, chunk_index] = coordinates::split(position);
+  glm::ivec3 chunk_origin = position - local_position;
+
+  const Chunk *chunk = cache.get_chunk(chunk_index);
+  if(!chunk)
+    return EmptyRegion{ .origin = chunk_origin, .dimension = glm::ivec3(CHUNK_WIDTH, CHUNK_WIDTH, CHUNK_HEIGHT) };
+
+  int section = local_position.z / CHUNK_SECTION_HEIGHT;
+  if(chunk->occupancy[section] == 0)
+    return EmptyRegion{ .origin = chunk_origin + glm::ivec3(0, 0, section * CHUNK_SECTION_HEIGHT), .dimension = glm::ivec3(CHUNK_WIDTH, CHUNK_WIDTH, CHUNK_SECTION_HEIGHT) };
+
+  return std::nullopt;
+}
+
+// Regions that find_empty_region() can skip are aligned to these, so we only
+// need to look for one when stepping across one of their boundaries
+static constexpr glm::ivec3 REGION_DIMENSION = glm::ivec3(CHUNK_WIDTH, CHUNK_WIDTH, CHUNK_SECTION_HEIGHT);
+static_assert((CHUNK_WIDTH & (CHUNK_WIDTH - 1)) == 0 && (CHUNK_SECTION_HEIGHT & (CHUNK_SECTION_HEIGHT - 1)) == 0);
+
+// Most rays that hit anything hit it within a few blocks, as in a cave, and
+// for those looking for empty regions costs more than it saves. So we only
+// start looking after this many plain steps.
+static constexpr int PLAIN_STEP_COUNT = 32;
+
+static RayCastBlocksResult ray_cast_blocks(ChunkCache& cache, const Ray& ray)
 {
-  glm::ivec3 iposition = glm::floor(position);
+  glm::ivec3 iposition = glm::floor(ray.position);
 
-  // 1: Check if we are inside a block already
-  if(const Block * block = get_block(world, iposition); block && block->id != BLOCK_ID_NONE)
+  // Special case if direction is zero, so that we cannot actually step in any directions
+  if(ray.direction == glm::vec3(0.0f))
   {
+    const Block *block = cache.get_block(iposition);
+
     RayCastBlocksResult result = {};
-    result.type     = RayCastBlocksResult::Type::INSIDE_BLOCK;
+    result.type     = block && block->id != BLOCK_ID_NONE ? RayCastBlocksResult::Type::INSIDE_BLOCK : RayCastBlocksResult::Type::NONE;
     result.position = iposition;
     return result;
   }
 
-  // 2: Special case if direction is zero, so that we cannot actually step in any directions
-  if(direction == glm::vec3(0.0f))
+  glm::ivec3 steps;
+  glm::vec3  inverse_direction;
+  glm::vec3  t_deltas;
+  glm::vec3  t_maxs;
+  for(int i=0; i<3; ++i)
   {
-    RayCastBlocksResult result = {};
-    result.type = RayCastBlocksResult::Type::NONE;
-    return result;
+    steps[i]             = ray.direction[i] < 0.0f ? -1 : ray.direction[i] > 0.0f ? 1 : 0;
+    inverse_direction[i] = 1.0f / ray.direction[i];
+    t_deltas[i]          = std::abs(inverse_direction[i]);
   }
 
+  auto reset_t_maxs = [&]() {
+    for(int i=0; i<3; ++i)
+      t_maxs[i] = steps[i] != 0
+        ? (iposition[i] + (steps[i] > 0 ? 1 : 0) - ray.position[i]) * inverse_direction[i]
+        : std::numeric_limits<float>::infinity();
+  };
+
+  // Walk block by block with the usual incremental DDA, until we hit
+  // something, reach the end of the ray, or stop(axis) says to stop after
+  // stepping along axis
+  int axis = -1; // Axis along which we last stepped, or -1 if we are still in the starting block
+  auto walk = [&](auto stop) -> std::optional<RayCastBlocksResult> {
+    for(;;)
+    {
+      if(const Block *block = cache.get_block(iposition); block && block->id != BLOCK_ID_NONE)
+      {
+        RayCastBlocksResult result = {};
+        result.position = iposition;
+        if(axis == -1)
+          result.type = RayCastBlocksResult::Type::INSIDE_BLOCK;
+        else
+        {
+          result.type         = RayCastBlocksResult::Type::HIT;
+          result.normal       = glm::ivec3(0);
+          result.normal[axis] = -steps[axis];
+        }
+        return result;
+      }
+
+      int min_i = 0;
+      for(int i=1; i<3; ++i)
+        if(t_maxs[min_i] > t_maxs[i])
+          min_i = i;
+
+      if(ray.length < t_maxs[min_i])
+      {
+        RayCastBlocksResult result = {};
+        result.type = RayCastBlocksResult::Type::NONE;
+        return result;
+      }
+
+      axis = min_i;
+      iposition[min_i] += steps[min_i];
+      t_maxs[min_i]    += t_deltas[min_i];
+      if(stop(min_i))
+        return std::nullopt;
+    }
+  };
+
+  // 1: Walk the first PLAIN_STEP_COUNT blocks without looking for empty regions
+  reset_t_maxs();
+  int step_count = 0;
+  if(std::optional<RayCastBlocksResult> result = walk([&](int) { return ++step_count == PLAIN_STEP_COUNT; }))
+    return *result;
+
   for(;;)
   {
-    // 3: Find the direction to step in
-    float min_t = std::numeric_limits<float>::infinity();
-    int min_step;
-    int min_i;
-    for(size_t i=0; i<3; ++i)
+    // 2: Skip over empty regions for as long as we find them. Find the face
+    //    through which we leave each, measuring t from the start of the ray
+    //    so that no error accumulates.
+    while(std::optional<EmptyRegion> region = find_empty_region(cache, iposition))
     {
-      int step;
-      int target;
-      if(direction[i] < 0.0f)
+      // Nothing above or below the world can ever be hit
+      if((iposition.z < 0 && steps.z <= 0) || (iposition.z >= CHUNK_HEIGHT && steps.z >= 0))
       {
-        step   = -1;
-        target = iposition[i];
+        RayCastBlocksResult result = {};
+        result.type = RayCastBlocksResult::Type::NONE;
+        return result;
       }
-      else if(direction[i] > 0.0f)
+
+      float min_t = std::numeric_limits<float>::infinity();
+      int   min_i = 0;
+      for(int i=0; i<3; ++i)
       {
-        step   = 1;
-        target = iposition[i] + 1;
+        if(steps[i] == 0)
+          continue;
+
+        int   target = steps[i] > 0 ? region->origin[i] + region->dimension[i] : region->origin[i];
+        float t      = (target - ray.position[i]) * inverse_direction[i];
+        if(min_t > t)
+        {
+          min_t = t;
+          min_i = i;
+        }
       }
-      else
-        continue;
 
-      float t = (target - position[i]) / direction[i];
-      if(min_t > t)
+      if(ray.length < min_t)
       {
-        min_t = t;
-        min_step = step;
-        min_i    = i;
+        RayCastBlocksResult result = {};
+        result.type = RayCastBlocksResult::Type::NONE;
+        return result;
       }
-    }
 
-    // 4: Check if the ray is actually long enough to step in that direction
-    if(length < min_t)
-    {
-      RayCastBlocksResult result = {};
-      result.type = RayCastBlocksResult::Type::NONE;
-      return result;
+      // Step into the block just past that face. Along the other axes we
+      // are still within the region, which also guards against rounding.
+      iposition        = glm::clamp(glm::ivec3(glm::floor(ray.position + min_t * ray.direction)), region->origin, region->origin + region->dimension - glm::ivec3(1));
+      iposition[min_i] = steps[min_i] > 0 ? region->origin[min_i] + region->dimension[min_i] : region->origin[min_i] - 1;
+      axis             = min_i;
+      reset_t_maxs();
     }
 
-    // 5: Step and see if we hit a block
-    iposition[min_i] += min_step;
-    position += min_t * direction;
-    length   -= min_t;
-    if(const Block * block = get_block(world, iposition); block && block->id != BLOCK_ID_NONE)
-    {
-      RayCastBlocksResult result = {};
-      result.type          = RayCastBlocksResult::Type::HIT;
-      result.position      = iposition;
-      result.normal        = glm::ivec3(0);
-      result.normal[min_i] = -min_step;
-      return result;
-    }
+    // 3: Walk the region we are in until we step into another one
+    if(std::optional<RayCastBlocksResult> result = walk([&](int i) { return (iposition[i] & (REGION_DIMENSION[i] - 1)) == (steps[i] > 0 ? 0 : REGION_DIMENSION[i] - 1); }))
+      return *result;
   }
 }
 
-#pragma GCC diagnostic pop
+RayCastBlocksResult ray_cast_blocks(const World& world, glm::vec3 position, glm::vec3 direction, float length)
+{
+  ChunkCache cache(world);
+  return ray_cast_blocks(cache, Ray{ .position = position, .direction = direction, .length = length });
+}
+
+void ray_cast_blocks(const World& world, std::span<const Ray> rays, std::span<RayCastBlocksResult> results)
+{
+  assert(rays.size() == results.size());
+
+  ChunkCache cache(world);
+  for(size_t i=0; i<rays.size(); ++i)
+    results[i] = ray_cast_blocks(cache, rays[i]);
+}
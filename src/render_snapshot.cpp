@@ -0,0 +1,73 @@
+#include <render_snapshot.hpp>
+
+#include <unordered_map>
+
+RenderSnapshot make_render_snapshot(const World& world, std::uint64_t tick)
+{
+  const Entities& entities = world.entities;
+  const Player&   player   = world.players.front();
+
+  RenderSnapshot snapshot = {};
+  snapshot.tick = tick;
+  snapshot.entities.reserve(entities.size());
+  for(size_t i=0; i<entities.size(); ++i)
+    snapshot.entities.push_back(RenderSnapshot::Entity{
+      .handle    = entities.handle(i),
+      .id        = entities.render.ids[i],
+      .transform = entities.transform(i),
+      .aabb      = entity_get_aabb(entities, i),
+      .eye       = entities.transforms.eyes[i],
+    });
+
+  size_t index = entities.index(player.entity);
+  snapshot.player_index    = index;
+  snapshot.player_velocity = entities.physics.velocities[index];
+  snapshot.player_collided = entities.physics.collided[index];
+  snapshot.player_grounded = entities.physics.grounded[index];
+  snapshot.player_sleeping = entities.physics.sleeping[index];
+  if(const Block *block = get_block(world, glm::floor(entities.physics.positions[index])))
+    snapshot.player_block = *block;
+
+  snapshot.selection = player.selection;
+  snapshot.placement = player.placement;
+  return snapshot;
+}
+
+RenderSnapshot interpolate_render_snapshots(const RenderSnapshot& previous, const RenderSnapshot& current, float alpha)
+{
+  RenderSnapshot snapshot = current;
+  if(previous.tick == current.tick)
+    return snapshot;
+
+  // Dense indices only move when entities are created or destroyed, so
+  // try the same index first
+  std::unordered_map<std::uint32_t, size_t> previous_indices;
+  auto find_previous = [&](size_t i) -> const RenderSnapshot::Entity * {
+    EntityHandle handle = current.entities[i].handle;
+    if(i < previous.entities.size() && previous.entities[i].handle == handle)
+      return &previous.entities[i];
+
+    if(previous_indices.empty())
+      for(size_t j=0; j<previous.entities.size(); ++j)
+        previous_indices.emplace(previous.entities[j].handle.slot, j);
+
+    auto it = previous_indices.find(handle.slot);
+    if(it == previous_indices.end() || previous.entities[it->second].handle != handle)
+      return nullptr;
+    return &previous.entities[it->second];
+  };
+
+  for(size_t i=0; i<snapshot.entities.size(); ++i)
+  {
+    const RenderSnapshot::Entity *from = find_previous(i);
+    if(!from)
+      continue;
+
+    RenderSnapshot::Entity& entity = snapshot.entities[i];
+    glm::vec3 position = from->transform.position + (entity.transform.position - from->transform.position) * alpha;
+    entity.aabb.position     += position - entity.transform.position;
+    entity.transform.position = position;
+    entity.transform.rotation = glm::slerp(from->transform.rotation, entity.transform.rotation, alpha);
+  }
+  return snapshot;
+}
@@ -1,6 +1,5 @@
 #include <resource_pack.hpp>
 
-#include <unordered_set>
 #include <unordered_map>
 
 #include <yaml-cpp/yaml.h>
@@ -15,22 +14,20 @@ ResourcePack load_resource_pack(std::string_view path)
   // 1: Blocks
   YAML::Node blocks = node["blocks"];
 
-  std::unordered_set<std::string>                block_texture_filenames_set;
   std::vector<std::string>                       block_texture_filenames;
   std::unordered_map<std::string, std::uint32_t> block_texture_indices_map;
 
+  // Indices are assigned in order of first appearance in the manifest, so
+  // that they are the same on every run
   for(YAML::Node block : blocks)
   {
     YAML::Node textures = block["textures"];
     for(size_t i=0; i<6; ++i)
-      block_texture_filenames_set.insert(textures[i].as<std::string>());
-  }
-
-  std::uint32_t i = 0;
-  for(const std::string& block_texture_filename : block_texture_filenames_set)
-  {
-    block_texture_filenames.push_back(fmt::format("{}/{}", path, block_texture_filename));
-    block_texture_indices_map.emplace(block_texture_filename, i++);
+    {
+      std::string block_texture_filename = textures[i].as<std::string>();
+      if(block_texture_indices_map.try_emplace(block_texture_filename, block_texture_filenames.size()).second)
+        block_texture_filenames.push_back(fmt::format("{}/{}", path, block_texture_filename));
+    }
   }
 
   resource_pack.blocks_texture_array = std::make_unique<graphics::TextureArray>(block_texture_filenames);
@@ -0,0 +1,159 @@
+#include <section_visibility.hpp>
+
+#include <directions.hpp>
+
+#include <glm/gtx/hash.hpp>
+
+#include <unordered_set>
+#include <vector>
+#include <bitset>
+
+static_assert(std::size(DIRECTIONS) == SectionVisibility::FACE_COUNT);
+
+static constexpr int SECTION_VOLUME = CHUNK_WIDTH * CHUNK_WIDTH * CHUNK_SECTION_HEIGHT;
+
+SectionVisibility SectionVisibility::all()
+{
+  SectionVisibility visibility;
+  visibility.m_bits = (std::uint64_t(1) << (FACE_COUNT * FACE_COUNT)) - 1;
+  return visibility;
+}
+
+void SectionVisibility::connect(int face1, int face2)
+{
+  m_bits |= std::uint64_t(1) << (face1 * FACE_COUNT + face2);
+  m_bits |= std::uint64_t(1) << (face2 * FACE_COUNT + face1);
+}
+
+bool SectionVisibility::connected(int face1, int face2) const
+{
+  return m_bits & (std::uint64_t(1) << (face1 * FACE_COUNT + face2));
+}
+
+static inline int section_offset(glm::ivec3 position)
+{
+  return (position.z * CHUNK_WIDTH + position.y) * CHUNK_WIDTH + position.x;
+}
+
+static inline glm::ivec3 section_position(int offset)
+{
+  return glm::ivec3(offset % CHUNK_WIDTH, offset / CHUNK_WIDTH % CHUNK_WIDTH, offset / (CHUNK_WIDTH * CHUNK_WIDTH));
+}
+
+// Faces of the section that the block at position lies on, as a bitmask
+static inline unsigned touched_faces(glm::ivec3 position)
+{
+  const glm::ivec3 max = glm::ivec3(CHUNK_WIDTH, CHUNK_WIDTH, CHUNK_SECTION_HEIGHT) - glm::ivec3(1);
+
+  unsigned faces = 0;
+  for(int i=0; i<3; ++i)
+  {
+    if(position[i] == 0)      faces |= 1u << (2 * i + 0);
+    if(position[i] == max[i]) faces |= 1u << (2 * i + 1);
+  }
+  return faces;
+}
+
+SectionVisibility compute_section_visibility(const Chunk& chunk, int section)
+{
+  if(chunk.occupancy[section] == 0)
+    return SectionVisibility::all();
+
+  const int z_base = section * CHUNK_SECTION_HEIGHT;
+  auto empty = [&](glm::ivec3 position) {
+    return chunk.blocks[z_base + position.z][position.y][position.x].id == BLOCK_ID_NONE;
+  };
+
+  // Flood fill every connected region of empty blocks, and connect all the
+  // faces that each region touches with each other
+  SectionVisibility           visibility;
+  std::bitset<SECTION_VOLUME> visited;
+  std::vector<int>            stack;
+  stack.reserve(SECTION_VOLUME);
+  for(int offset=0; offset<SECTION_VOLUME; ++offset)
+  {
+    if(visited[offset] || !empty(section_position(offset)))
+      continue;
+
+    unsigned faces = 0;
+    visited[offset] = true;
+    stack.push_back(offset);
+    while(!stack.empty())
+    {
+      glm::ivec3 position = section_position(stack.back());
+      stack.pop_back();
+
+      faces |= touched_faces(position);
+      for(glm::ivec3 direction : DIRECTIONS)
+      {
+        glm::ivec3 neighbour_position = position + direction;
+        if(glm::any(glm::lessThan(neighbour_position, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(neighbour_position, glm::ivec3(CHUNK_WIDTH, CHUNK_WIDTH, CHUNK_SECTION_HEIGHT))))
+          continue;
+
+        int neighbour_offset = section_offset(neighbour_position);
+        if(visited[neighbour_offset] || !empty(neighbour_position))
+          continue;
+
+        visited[neighbour_offset] = true;
+        stack.push_back(neighbour_offset);
+      }
+    }
+
+    for(int face1=0; face1<SectionVisibility::FACE_COUNT; ++face1)
+      for(int face2=face1+1; face2<SectionVisibility::FACE_COUNT; ++face2)
+        if((faces & (1u << face1)) && (faces & (1u << face2)))
+          visibility.connect(face1, face2);
+  }
+  return visibility;
+}
+
+void traverse_visible_sections(
+  glm::ivec3 start,
+  const std::function<const SectionVisibility*(glm::ivec3)>& get_visibility,
+  const std::function<bool(glm::ivec3)>&                     in_frustum,
+  const std::function<void(glm::ivec3)>&                     visit
+)
+{
+  struct Node
+  {
+    glm::ivec3 section;
+    int        entry_face; // -1 for the start section
+    unsigned   directions; // Bitmask of directions stepped in to get here
+  };
+
+  std::unordered_set<glm::ivec3> visited;
+  std::vector<Node>              queue;
+
+  if(!get_visibility(start))
+    return;
+
+  visited.insert(start);
+  queue.push_back(Node{ .section = start, .entry_face = -1, .directions = 0 });
+  for(size_t head=0; head<queue.size(); ++head)
+  {
+    Node node = queue[head];
+    visit(node.section);
+
+    const SectionVisibility& visibility = *get_visibility(node.section);
+    for(int face=0; face<SectionVisibility::FACE_COUNT; ++face)
+    {
+      // Never turn back towards the camera. Opposite directions differ only
+      // in the lowest bit of their index.
+      if(node.directions & (1u << (face ^ 1)))
+        continue;
+
+      if(node.entry_face != -1 && !visibility.connected(node.entry_face, face))
+        continue;
+
+      glm::ivec3 neighbour = node.section + DIRECTIONS[face];
+      if(neighbour.z < 0 || neighbour.z >= CHUNK_SECTION_COUNT)
+        continue;
+
+      if(visited.contains(neighbour) || !get_visibility(neighbour) || !in_frustum(neighbour))
+        continue;
+
+      visited.insert(neighbour);
+      queue.push_back(Node{ .section = neighbour, .entry_face = face ^ 1, .directions = node.directions | (1u << face) });
+    }
+  }
+}
@@ -0,0 +1,110 @@
+#include <simulation.hpp>
+
+#include <physics.hpp>
+#include <player_control.hpp>
+#include <profiler.hpp>
+
+#include <algorithm>
+
+static constexpr Simulation::Clock::duration FIXED_STEP = std::chrono::duration_cast<Simulation::Clock::duration>(std::chrono::duration<float>(Simulation::FIXED_DT));
+
+float Simulation::Snapshots::alpha(Clock::time_point now) const
+{
+  float elapsed = std::chrono::duration<float>(now - current_time).count();
+  return std::clamp(elapsed / FIXED_DT, 0.0f, 1.0f);
+}
+
+Simulation::Simulation(World& world, WorldGenerator& world_generator, LightManager& light_manager) :
+  m_world(world),
+  m_world_generator(world_generator),
+  m_light_manager(light_manager),
+  m_input{},
+  m_tick(0),
+  m_timer(FIXED_STEP, MAX_CATCH_UP_TICKS)
+{
+  auto snapshot = std::make_shared<const RenderSnapshot>(make_render_snapshot(m_world, m_tick));
+  m_snapshots = Snapshots{ .previous = snapshot, .current = snapshot, .current_time = m_timer.last_tick(), .tick_stats = {} };
+
+  m_thread = std::jthread([this](std::stop_token stoken) { run(stoken); });
+}
+
+void Simulation::push_input(const PlayerInput& input)
+{
+  std::lock_guard guard(m_input_mutex);
+  double cursor_motion_x = m_input.cursor_motion_x + input.cursor_motion_x;
+  double cursor_motion_y = m_input.cursor_motion_y + input.cursor_motion_y;
+  m_input = input;
+  m_input.cursor_motion_x = cursor_motion_x;
+  m_input.cursor_motion_y = cursor_motion_y;
+}
+
+Simulation::Snapshots Simulation::snapshots() const
+{
+  std::lock_guard guard(m_snapshots_mutex);
+  return m_snapshots;
+}
+
+void Simulation::run(std::stop_token stoken)
+{
+  while(!stoken.stop_requested())
+  {
+    std::this_thread::sleep_until(m_timer.next_tick());
+
+    // Ticks caught up on are each stamped with the time they were due, so
+    // that interpolation still sees them a step apart
+    size_t count = m_timer.poll(Clock::now());
+    for(size_t i=0; i<count && !stoken.stop_requested(); ++i)
+    {
+      Clock::time_point begin    = Clock::now();
+      auto              snapshot = tick();
+      m_timer.record_tick(Clock::now() - begin);
+
+      std::lock_guard guard(m_snapshots_mutex);
+      m_snapshots.previous     = std::move(m_snapshots.current);
+      m_snapshots.current      = std::move(snapshot);
+      m_snapshots.current_time = m_timer.last_tick() - (count - 1 - i) * m_timer.step();
+      m_snapshots.tick_stats   = m_timer.stats();
+    }
+  }
+}
+
+std::shared_ptr<const RenderSnapshot> Simulation::tick()
+{
+  PROFILE_ZONE("tick");
+
+  PlayerInput input;
+  {
+    std::lock_guard guard(m_input_mutex);
+    input = m_input;
+    m_input.cursor_motion_x = 0.0;
+    m_input.cursor_motion_y = 0.0;
+  }
+
+  std::shared_ptr<const RenderSnapshot> snapshot;
+  {
+    std::lock_guard guard(m_world_mutex);
+
+    // 1: Input Handling
+    Player& player = m_world.players.front();
+    player.key_space = input.key_space;
+    player.key_w     = input.key_w;
+    player.key_a     = input.key_a;
+    player.key_s     = input.key_s;
+    player.key_d     = input.key_d;
+
+    player.mouse_button_left  = input.mouse_button_left;
+    player.mouse_button_right = input.mouse_button_right;
+
+    player.cursor_motion_x = input.cursor_motion_x;
+    player.cursor_motion_y = input.cursor_motion_y;
+
+    // 2: Actual Update
+    m_world_generator.update(m_world, m_light_manager);
+    update_player_control(m_world, m_light_manager, FIXED_DT);
+    update_physics(m_world, FIXED_DT);
+    m_light_manager.update(m_world);
+
+    snapshot = std::make_shared<const RenderSnapshot>(make_render_snapshot(m_world, ++m_tick));
+  }
+  return snapshot;
+}
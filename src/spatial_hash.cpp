@@ -0,0 +1,91 @@
+#include <spatial_hash.hpp>
+
+#include <glm/gtx/norm.hpp>
+
+#include <algorithm>
+
+glm::ivec3 SpatialHash::cell_min(const AABB& aabb)
+{
+  return glm::floor(aabb.position / CELL_SIZE);
+}
+
+glm::ivec3 SpatialHash::cell_max(const AABB& aabb)
+{
+  return glm::floor((aabb.position + aabb.dimension) / CELL_SIZE);
+}
+
+void SpatialHash::rebuild(std::span<const AABB> aabbs)
+{
+  m_aabbs.assign(aabbs.begin(), aabbs.end());
+
+  // Keep the cells around so that their storage can be reused across
+  // rebuilds, and only drop the ones that did not get anything this time.
+  for(auto& [cell, indices] : m_cells)
+    indices.clear();
+
+  for(std::uint32_t i=0; i<m_aabbs.size(); ++i)
+  {
+    glm::ivec3 min = cell_min(m_aabbs[i]);
+    glm::ivec3 max = cell_max(m_aabbs[i]);
+    for(int z = min.z; z<=max.z; ++z)
+      for(int y = min.y; y<=max.y; ++y)
+        for(int x = min.x; x<=max.x; ++x)
+          m_cells[glm::ivec3(x, y, z)].push_back(i);
+  }
+
+  std::erase_if(m_cells, [](const auto& item) { return item.second.empty(); });
+}
+
+void SpatialHash::query_aabb(const AABB& aabb, std::vector<std::uint32_t>& result) const
+{
+  glm::ivec3 min = cell_min(aabb);
+  glm::ivec3 max = cell_max(aabb);
+  for(int z = min.z; z<=max.z; ++z)
+    for(int y = min.y; y<=max.y; ++y)
+      for(int x = min.x; x<=max.x; ++x)
+      {
+        glm::ivec3 cell = glm::ivec3(x, y, z);
+
+        auto it = m_cells.find(cell);
+        if(it == m_cells.end())
+          continue;
+
+        for(std::uint32_t i : it->second)
+          if(glm::max(cell_min(m_aabbs[i]), min) == cell)
+            if(aabb_overlap(m_aabbs[i], aabb))
+              result.push_back(i);
+      }
+}
+
+void SpatialHash::query_radius(glm::vec3 center, float radius, std::vector<std::uint32_t>& result) const
+{
+  size_t begin = result.size();
+  query_aabb(AABB{ .position = center - glm::vec3(radius), .dimension = glm::vec3(2.0f * radius) }, result);
+
+  // Narrow down to boxes that actually reach into the sphere
+  auto it = std::remove_if(result.begin() + begin, result.end(), [&](std::uint32_t i) {
+    const AABB& aabb    = m_aabbs[i];
+    glm::vec3   closest = glm::clamp(center, aabb.position, aabb.position + aabb.dimension);
+    return glm::length2(closest - center) > radius * radius;
+  });
+  result.erase(it, result.end());
+}
+
+void SpatialHash::query_pairs(std::vector<std::pair<std::uint32_t, std::uint32_t>>& result) const
+{
+  size_t begin = result.size();
+  for(const auto& [cell, indices] : m_cells)
+    for(size_t a=0; a<indices.size(); ++a)
+      for(size_t b=a+1; b<indices.size(); ++b)
+      {
+        std::uint32_t i = std::min(indices[a], indices[b]);
+        std::uint32_t j = std::max(indices[a], indices[b]);
+        if(glm::max(cell_min(m_aabbs[i]), cell_min(m_aabbs[j])) == cell)
+          if(aabb_overlap(m_aabbs[i], m_aabbs[j]))
+            result.emplace_back(i, j);
+      }
+
+  // Iteration order of the cells is unspecified, so sort to keep whatever
+  // consumes the pairs deterministic.
+  std::sort(result.begin() + begin, result.end());
+}
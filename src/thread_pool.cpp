@@ -1,40 +1,244 @@
 #include <thread_pool.hpp>
 
+#include <profiler.hpp>
+#include <memory_registry.hpp>
+
+#include <fmt/format.h>
+
+#include <bit>
+
+const char *task_kind_name(TaskKind kind)
+{
+  switch(kind)
+  {
+  case TaskKind::GENERIC:      return "generic";
+  case TaskKind::CHUNK_INFO:   return "chunk_info";
+  case TaskKind::FAR_TERRAIN:  return "far_terrain";
+  case TaskKind::CHUNK_MESH:   return "chunk_mesh";
+  case TaskKind::ASSET_DECODE: return "asset_decode";
+  case TaskKind::COUNT:        break;
+  }
+  return "unknown";
+}
+
+/*************
+ * Histogram *
+ *************/
+float ThreadPool::Histogram::average_us() const
+{
+  return count != 0 ? static_cast<float>(total_us) / static_cast<float>(count) : 0.0f;
+}
+
+float ThreadPool::Histogram::percentile_us(float percentile) const
+{
+  if(count == 0)
+    return 0.0f;
+
+  std::uint64_t target = static_cast<std::uint64_t>(percentile * static_cast<float>(count));
+  std::uint64_t seen   = 0;
+  for(size_t i=0; i<HISTOGRAM_BUCKET_COUNT; ++i)
+  {
+    seen += buckets[i];
+    if(seen > target)
+      return static_cast<float>(std::uint64_t(1) << i); // Upper bound of the bucket
+  }
+  return static_cast<float>(std::uint64_t(1) << HISTOGRAM_BUCKET_COUNT);
+}
+
+void ThreadPool::WorkerState::AtomicHistogram::record(Clock::duration duration)
+{
+  std::uint64_t us     = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  size_t        bucket = std::min<size_t>(std::bit_width(us), HISTOGRAM_BUCKET_COUNT - 1);
+
+  count   .fetch_add(1,  std::memory_order_relaxed);
+  total_us.fetch_add(us, std::memory_order_relaxed);
+  buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void ThreadPool::WorkerState::AtomicHistogram::accumulate(Histogram& histogram) const
+{
+  histogram.count    += count   .load(std::memory_order_relaxed);
+  histogram.total_us += total_us.load(std::memory_order_relaxed);
+  for(size_t i=0; i<HISTOGRAM_BUCKET_COUNT; ++i)
+    histogram.buckets[i] += buckets[i].load(std::memory_order_relaxed);
+}
+
+/**************
+ * ThreadPool *
+ **************/
 ThreadPool& ThreadPool::instance()
 {
   static ThreadPool thread_pool;
   return thread_pool;
 }
 
-ThreadPool::ThreadPool()
+ThreadPool::ThreadPool() : m_enqueued{}, m_start_time(Clock::now())
 {
   unsigned count = std::thread::hardware_concurrency();
+  m_worker_states.reserve(count);
   m_threads.reserve(count);
   for(unsigned i=0; i<count; ++i)
-    m_threads.emplace_back([this](std::stop_token stoken)
+  {
+    WorkerState& state = *m_worker_states.emplace_back(std::make_unique<WorkerState>());
+    m_threads.emplace_back([this, &state](std::stop_token stoken) { worker(stoken, state); });
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  for(std::jthread& thread : m_threads) thread.request_stop();
+  for(std::jthread& thread : m_threads) thread.join();
+}
+
+// Only the tasks themselves, not whatever their closures captured
+static MemoryRegistry::Gauge& queue_memory()
+{
+  static MemoryRegistry::Gauge& gauge = MemoryRegistry::instance().gauge("thread_pool.queue");
+  return gauge;
+}
+
+void ThreadPool::worker(std::stop_token stoken, WorkerState& state)
+{
+  std::unique_lock lk(m_mutex);
+  for(;;)
+  {
+    m_cv.wait(lk, stoken, [this](){ return !m_tasks.empty(); });
+    if(stoken.stop_requested())
+      return;
+
+    Task task = std::move(m_tasks.front());
+    m_tasks.pop_front();
+    queue_memory().set(m_tasks.size() * sizeof(Task), m_tasks.size());
+
+    lk.unlock();
     {
-      std::unique_lock lk(m_mutex);
-      for(;;)
-      {
-        m_cv.wait(lk, stoken, [this](){ return !m_tasks.empty(); });
-        if(stoken.stop_requested())
-          return;
-
-        auto task = std::move(m_tasks.front());
-        m_tasks.pop_front();
-
-        lk.unlock();
-        task();
-        lk.lock();
-      }
-    });
+      WorkerState::KindState& kind_state = state.kinds[static_cast<size_t>(task.kind)];
+
+      Clock::time_point started_at = Clock::now();
+      kind_state.started.fetch_add(1, std::memory_order_relaxed);
+      kind_state.wait_time.record(started_at - task.enqueued_at);
+
+      task.function();
+
+      Clock::time_point completed_at = Clock::now();
+      kind_state.completed.fetch_add(1, std::memory_order_relaxed);
+      kind_state.run_time.record(completed_at - started_at);
+      Profiler::instance().record(task_kind_name(task.kind), started_at, completed_at);
+      state.busy_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(completed_at - started_at).count(), std::memory_order_relaxed);
+    }
+    lk.lock();
+  }
 }
 
 void ThreadPool::enqueue(std::function<void()> task)
+{
+  enqueue(TaskKind::GENERIC, std::move(task));
+}
+
+void ThreadPool::enqueue(TaskKind kind, std::function<void()> task)
 {
   std::unique_lock lk(m_mutex);
-  m_tasks.push_back(std::move(task));
+  m_tasks.push_back(Task{
+    .kind        = kind,
+    .enqueued_at = Clock::now(),
+    .function    = std::move(task),
+  });
+  ++m_enqueued[static_cast<size_t>(kind)];
+  queue_memory().set(m_tasks.size() * sizeof(Task), m_tasks.size());
   lk.unlock();
   m_cv.notify_one();
 }
 
+size_t ThreadPool::queue_depth() const
+{
+  std::lock_guard lk(m_mutex);
+  return m_tasks.size();
+}
+
+ThreadPool::Stats ThreadPool::stats() const
+{
+  Stats stats = {};
+  {
+    std::lock_guard lk(m_mutex);
+    stats.queue_depth = m_tasks.size();
+    for(size_t i=0; i<static_cast<size_t>(TaskKind::COUNT); ++i)
+      stats.kinds[i].enqueued = m_enqueued[i];
+    for(const Task& task : m_tasks)
+      ++stats.kinds[static_cast<size_t>(task.kind)].pending;
+  }
+
+  std::uint64_t uptime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start_time).count();
+  for(const std::unique_ptr<WorkerState>& state : m_worker_states)
+  {
+    for(size_t i=0; i<static_cast<size_t>(TaskKind::COUNT); ++i)
+    {
+      const WorkerState::KindState& kind_state = state->kinds[i];
+      stats.kinds[i].started   += kind_state.started  .load(std::memory_order_relaxed);
+      stats.kinds[i].completed += kind_state.completed.load(std::memory_order_relaxed);
+      kind_state.wait_time.accumulate(stats.kinds[i].wait_time);
+      kind_state.run_time .accumulate(stats.kinds[i].run_time);
+    }
+
+    stats.workers.push_back(WorkerStats{
+      .busy_ns   = state->busy_ns.load(std::memory_order_relaxed),
+      .uptime_ns = uptime_ns,
+    });
+  }
+  return stats;
+}
+
+/*********
+ * Stats *
+ *********/
+std::vector<float> ThreadPool::Stats::utilisations(const Stats *previous) const
+{
+  std::vector<float> result;
+  for(size_t i=0; i<workers.size(); ++i)
+  {
+    std::uint64_t busy_ns   = workers[i].busy_ns;
+    std::uint64_t uptime_ns = workers[i].uptime_ns;
+    if(previous && i < previous->workers.size())
+    {
+      busy_ns   -= previous->workers[i].busy_ns;
+      uptime_ns -= previous->workers[i].uptime_ns;
+    }
+    result.push_back(uptime_ns != 0 ? std::min(static_cast<float>(busy_ns) / static_cast<float>(uptime_ns), 1.0f) : 0.0f);
+  }
+  return result;
+}
+
+static void dump_histogram_json(std::ostream& os, const ThreadPool::Histogram& histogram)
+{
+  os << fmt::format(R"({{"count": {}, "total_us": {}, "buckets": [)", histogram.count, histogram.total_us);
+  for(size_t i=0; i<ThreadPool::HISTOGRAM_BUCKET_COUNT; ++i)
+    os << (i != 0 ? ", " : "") << histogram.buckets[i];
+  os << "]}";
+}
+
+void ThreadPool::Stats::dump_json(std::ostream& os) const
+{
+  os << "{\n";
+  os << fmt::format(R"(  "queue_depth": {},)", queue_depth) << '\n';
+
+  os << R"(  "kinds": {)" << '\n';
+  for(size_t i=0; i<static_cast<size_t>(TaskKind::COUNT); ++i)
+  {
+    const KindStats& kind = kinds[i];
+    os << fmt::format(R"(    "{}": {{"enqueued": {}, "started": {}, "completed": {}, "pending": {}, "wait_time": )",
+        task_kind_name(static_cast<TaskKind>(i)), kind.enqueued, kind.started, kind.completed, kind.pending);
+    dump_histogram_json(os, kind.wait_time);
+    os << R"(, "run_time": )";
+    dump_histogram_json(os, kind.run_time);
+    os << "}" << (i + 1 != static_cast<size_t>(TaskKind::COUNT) ? "," : "") << '\n';
+  }
+  os << "  },\n";
+
+  std::vector<float> worker_utilisations = utilisations();
+  os << R"(  "workers": [)" << '\n';
+  for(size_t i=0; i<workers.size(); ++i)
+    os << fmt::format(R"(    {{"busy_ns": {}, "uptime_ns": {}, "utilisation": {}}})", workers[i].busy_ns, workers[i].uptime_ns, worker_utilisations[i])
+       << (i + 1 != workers.size() ? "," : "") << '\n';
+  os << "  ]\n";
+
+  os << "}\n";
+}
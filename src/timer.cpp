@@ -1,22 +1,42 @@
 #include <timer.hpp>
 
-#include <GLFW/glfw3.h>
+#include <algorithm>
+
 #include <assert.h>
 
-Timer::Timer()
+Timer::Timer(Clock::duration step, size_t max_catch_up, Clock::time_point start) :
+  m_step(step),
+  m_max_catch_up(max_catch_up),
+  m_next_tick(start + step),
+  m_stats{}
+{
+  assert(step > Clock::duration::zero());
+  assert(max_catch_up > 0);
+}
+
+size_t Timer::poll(Clock::time_point now)
 {
-  m_previous_time = glfwGetTime();
+  if(now < m_next_tick)
+    return 0;
+
+  Clock::duration lateness = now - m_next_tick;
+  m_stats.last_lateness = lateness;
+  m_stats.max_lateness  = std::max(m_stats.max_lateness, lateness);
+
+  size_t due   = lateness / m_step + 1;
+  size_t count = std::min(due, m_max_catch_up);
+  m_stats.dropped_tick_count += due - count;
+
+  // Dropped steps are skipped over entirely, so the schedule stays aligned
+  // to the start time
+  m_next_tick += m_step * due;
+  return count;
 }
 
-bool Timer::tick(float dt)
+void Timer::record_tick(Clock::duration duration)
 {
-  float time = glfwGetTime();
-  assert(time >= m_previous_time);
-  if(time >= m_previous_time + dt)
-  {
-    m_previous_time += dt;
-    return true;
-  }
-  else
-    return false;
+  ++m_stats.tick_count;
+  m_stats.last_tick_duration   = duration;
+  m_stats.max_tick_duration    = std::max(m_stats.max_tick_duration, duration);
+  m_stats.total_tick_duration += duration;
 }
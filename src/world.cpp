@@ -13,10 +13,10 @@ static inline glm::vec3 clamp(glm::vec3 v, float max)
     return std::min(glm::length(v), max) * glm::normalize(v);
 }
 
-AABB entity_get_aabb(const Entity& entity)
+AABB entity_get_aabb(const Entities& entities, size_t index)
 {
-  glm::vec3 position = entity.transform.position;
-  glm::vec3 dimension = entity.dimension;
+  glm::vec3 position  = entities.physics.positions[index];
+  glm::vec3 dimension = entities.physics.dimensions[index];
 
   position.x -= dimension.x / 2.0f;
   position.y -= dimension.y / 2.0f;
@@ -27,19 +27,49 @@ AABB entity_get_aabb(const Entity& entity)
   };
 }
 
-void entity_apply_impulse(Entity& entity, glm::vec3 force)
+static std::vector<EntityHandle> to_handles(const World& world, const std::vector<std::uint32_t>& indices)
 {
-  entity.velocity += force;
+  std::vector<EntityHandle> handles;
+  handles.reserve(indices.size());
+  for(std::uint32_t index : indices)
+    handles.push_back(world.entities.handle(index));
+  return handles;
 }
 
-void entity_apply_force(Entity& entity, glm::vec3 force, float dt)
+std::vector<EntityHandle> query_entities(const World& world, const AABB& aabb)
 {
-  entity_apply_impulse(entity, dt * force);
+  std::vector<std::uint32_t> indices;
+  world.entity_hash.query_aabb(aabb, indices);
+  return to_handles(world, indices);
 }
 
-void entity_apply_force(Entity& entity, glm::vec3 force, float dt, float max)
+std::vector<EntityHandle> query_entities(const World& world, glm::vec3 center, float radius)
 {
-  entity_apply_impulse(entity, clamp(dt * force, max));
+  std::vector<std::uint32_t> indices;
+  world.entity_hash.query_radius(center, radius, indices);
+  return to_handles(world, indices);
+}
+
+void entity_wake(Entities& entities, size_t index)
+{
+  entities.physics.idle_ticks[index] = 0;
+  entities.physics.sleeping[index]   = false;
+}
+
+void entity_apply_impulse(Entities& entities, size_t index, glm::vec3 force)
+{
+  entity_wake(entities, index);
+  entities.physics.velocities[index] += force;
+}
+
+void entity_apply_force(Entities& entities, size_t index, glm::vec3 force, float dt)
+{
+  entity_apply_impulse(entities, index, dt * force);
+}
+
+void entity_apply_force(Entities& entities, size_t index, glm::vec3 force, float dt, float max)
+{
+  entity_apply_impulse(entities, index, clamp(dt * force, max));
 }
 
 /******************
@@ -83,6 +113,133 @@ const Block* get_block(const World& world, glm::ivec3 position)
   return ::get_block(it->second, local_position);
 }
 
+/*************
+ * Occupancy *
+ *************/
+void update_occupancy(Chunk& chunk)
+{
+  for(int i=0; i<CHUNK_SECTION_COUNT; ++i)
+    chunk.occupancy[i] = 0;
+
+  for(int z=0; z<CHUNK_HEIGHT; ++z)
+    for(int y=0; y<CHUNK_WIDTH; ++y)
+      for(int x=0; x<CHUNK_WIDTH; ++x)
+        if(chunk.blocks[z][y][x].id != BLOCK_ID_NONE)
+          chunk.occupancy[z / CHUNK_SECTION_HEIGHT] |= brick_bit(glm::ivec3(x, y, z));
+}
+
+void update_occupancy(Chunk& chunk, glm::ivec3 position)
+{
+  if(!get_block(chunk, position))
+    return;
+
+  // Only the brick containing the block can have changed
+  glm::ivec3 origin = position / BRICK_WIDTH * BRICK_WIDTH;
+  for(int z = origin.z; z<origin.z+BRICK_WIDTH; ++z)
+    for(int y = origin.y; y<origin.y+BRICK_WIDTH; ++y)
+      for(int x = origin.x; x<origin.x+BRICK_WIDTH; ++x)
+        if(chunk.blocks[z][y][x].id != BLOCK_ID_NONE)
+        {
+          chunk.occupancy[position.z / CHUNK_SECTION_HEIGHT] |= brick_bit(position);
+          return;
+        }
+
+  chunk.occupancy[position.z / CHUNK_SECTION_HEIGHT] &= ~brick_bit(position);
+}
+
+void update_occupancy(World& world, glm::ivec3 position)
+{
+  auto [local_position, chunk_index] = coordinates::split(position);
+  if(auto it = world.chunks.find(chunk_index); it != world.chunks.end())
+    update_occupancy(it->second, local_position);
+}
+
+/*******
+ * LOD *
+ *******/
+static int lod_cell_index(int level, glm::ivec3 cell)
+{
+  glm::ivec3 dimension = lod_dimension(level);
+  if(cell.x < 0 || cell.x >= dimension.x) return -1;
+  if(cell.y < 0 || cell.y >= dimension.y) return -1;
+  if(cell.z < 0 || cell.z >= dimension.z) return -1;
+  return lod_cell_offset(level) + (cell.z * dimension.y + cell.y) * dimension.x + cell.x;
+}
+
+const Block* get_lod_block(const Chunk& chunk, int level, glm::ivec3 cell)
+{
+  if(level == 0)
+    return get_block(chunk, cell);
+
+  int index = lod_cell_index(level, cell);
+  return index != -1 ? &chunk.lod_cells[index] : nullptr;
+}
+
+static Block downsample(const Chunk& chunk, int level, glm::ivec3 cell)
+{
+  Block         result      = { .id = BLOCK_ID_NONE, .sky = false, .light_level = 0, .destroy_level = 0 };
+  std::uint32_t top_id      = BLOCK_ID_NONE;
+  int           solid_count = 0;
+
+  // Upper children first, so that top_id ends up being the topmost one
+  for(int dz=1; dz>=0; --dz)
+    for(int dy=0; dy<2; ++dy)
+      for(int dx=0; dx<2; ++dx)
+      {
+        const Block* child = get_lod_block(chunk, level - 1, cell * 2 + glm::ivec3(dx, dy, dz));
+        if(child->id != BLOCK_ID_NONE)
+        {
+          if(solid_count++ == 0)
+            top_id = child->id;
+        }
+        else
+        {
+          result.sky         = result.sky || child->sky;
+          result.light_level = std::max<std::uint32_t>(result.light_level, child->light_level);
+        }
+      }
+
+  if(solid_count >= 4)
+    result.id = top_id;
+
+  return result;
+}
+
+void update_lod(Chunk& chunk)
+{
+  for(int level=1; level<CHUNK_LOD_COUNT; ++level)
+  {
+    glm::ivec3 dimension = lod_dimension(level);
+    for(int z=0; z<dimension.z; ++z)
+      for(int y=0; y<dimension.y; ++y)
+        for(int x=0; x<dimension.x; ++x)
+        {
+          glm::ivec3 cell(x, y, z);
+          chunk.lod_cells[lod_cell_index(level, cell)] = downsample(chunk, level, cell);
+        }
+  }
+}
+
+void update_lod(Chunk& chunk, glm::ivec3 position)
+{
+  if(!get_block(chunk, position))
+    return;
+
+  // Only the cells containing the block can have changed
+  for(int level=1; level<CHUNK_LOD_COUNT; ++level)
+  {
+    glm::ivec3 cell = position / (1 << level);
+    chunk.lod_cells[lod_cell_index(level, cell)] = downsample(chunk, level, cell);
+  }
+}
+
+void update_lod(World& world, glm::ivec3 position)
+{
+  auto [local_position, chunk_index] = coordinates::split(position);
+  if(auto it = world.chunks.find(chunk_index); it != world.chunks.end())
+    update_lod(it->second, local_position);
+}
+
 /**************************
  * Invalidate them ALL!!! *
  **************************/
@@ -98,35 +255,30 @@ void invalidate_mesh(World& world, glm::ivec3 position)
     invalidate_mesh(it->second);
 }
 
+void wake_entities(World& world, glm::ivec3 position)
+{
+  // Grow the box by one block so that entities merely touching a face of the
+  // block, such as one standing on top of it, are included
+  AABB aabb = {
+    .position  = glm::vec3(position) - glm::vec3(1.0f),
+    .dimension = glm::vec3(3.0f),
+  };
+
+  std::vector<std::uint32_t> indices;
+  world.entity_hash.query_aabb(aabb, indices);
+  for(std::uint32_t index : indices)
+    entity_wake(world.entities, index);
+}
+
 World load_world(std::string_view path)
 {
   // That was a lie, we are just creating a new world for now
   World world;
-  world.entities = {
-    {
-      .id = 0,
-      .transform = {
-        .position = glm::vec3(0.0f, 0.0f, 50.0f),
-        .rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
-      },
-      .velocity  = glm::vec3(0.0f, 0.0f, 0.0f),
-      .dimension = glm::vec3(0.9f, 0.9f, 1.9f),
-      .eye       = 1.5f,
-    },
-    {
-      .id = 0,
-      .transform = {
-        .position = glm::vec3(0.0f, 0.0f, 50.0f),
-        .rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
-      },
-      .velocity  = glm::vec3(0.0f, 0.0f, 0.0f),
-      .dimension = glm::vec3(0.9f, 0.9f, 1.9f),
-      .eye       = 1.5f,
-    },
-  };
+  EntityHandle player_entity = world.entities.create(0, Transform{ .position = glm::vec3(0.0f, 0.0f, 50.0f), .rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f) }, glm::vec3(0.9f, 0.9f, 1.9f), 1.5f);
+  world.entities.create(0, Transform{ .position = glm::vec3(0.0f, 0.0f, 50.0f), .rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f) }, glm::vec3(0.9f, 0.9f, 1.9f), 1.5f);
   world.players = {
     {
-      .entity_id = 0,
+      .entity = player_entity,
 
       .key_w = false,
       .key_a = false,
@@ -2,6 +2,8 @@
 
 #include <coordinates.hpp>
 #include <noise.hpp>
+#include <profiler.hpp>
+#include <memory_registry.hpp>
 
 #include <GLFW/glfw3.h>
 
@@ -63,6 +65,34 @@ WorldGenerationConfig load_world_generation_config(std::string_view path)
   return config;
 }
 
+TerrainSampler::TerrainSampler(std::size_t seed, TerrainGenerationConfig config) : m_config(std::move(config))
+{
+  std::mt19937 prng(seed);
+  for(size_t i=0; i<m_config.layers.size(); ++i)
+    m_seeds.push_back(prng());
+}
+
+TerrainSampler::Sample TerrainSampler::sample(glm::vec2 position) const
+{
+  Sample result = { .height = 0.0f, .block_id = BLOCK_ID_NONE };
+  for(size_t i=0; i<m_config.layers.size(); ++i)
+  {
+    float height = layer_height(i, position);
+    if(height > 0.0f)
+    {
+      result.height  += height;
+      result.block_id = m_config.layers[i].block_id;
+    }
+  }
+  return result;
+}
+
+float TerrainSampler::layer_height(size_t layer, glm::vec2 position) const
+{
+  const LayerGenerationConfig& layer_config = m_config.layers[layer];
+  return std::max(layer_config.height_base + noise(m_seeds[layer], position, layer_config.height_noise), 0.0f);
+}
+
 template <class T>
 static inline size_t hash_combine(std::size_t seed, const T& v)
 {
@@ -70,17 +100,22 @@ static inline size_t hash_combine(std::size_t seed, const T& v)
   return seed ^ (hasher(v) + 0x9e3779b9 + (seed<<6) + (seed>>2));
 }
 
-WorldGenerator::WorldGenerator(WorldGenerationConfig config) : m_config(std::move(config)) {}
+WorldGenerator::WorldGenerator(WorldGenerationConfig config) : m_config(std::move(config)), m_terrain_sampler(m_config.seed, m_config.terrain) {}
 
 void WorldGenerator::update(World& world, LightManager& light_manager)
 {
+  PROFILE_ZONE("world_generator");
+
   const Player& player        = world.players.front();
-  const Entity& player_entity = world.entities.at(player.entity_id);
+  glm::vec3     player_position = world.entities.physics.positions[world.entities.index(player.entity)];
   glm::ivec2 center = {
-    std::floor(player_entity.transform.position.x / CHUNK_WIDTH),
-    std::floor(player_entity.transform.position.y / CHUNK_WIDTH),
+    std::floor(player_position.x / CHUNK_WIDTH),
+    std::floor(player_position.y / CHUNK_WIDTH),
   };
   try_load(world, light_manager, center, CHUNK_LOAD_RADIUS);
+
+  static MemoryRegistry::Gauge& chunk_memory = MemoryRegistry::instance().gauge("world.chunks");
+  chunk_memory.set(world.chunks.size() * sizeof(Chunk), world.chunks.size());
 }
 
 void WorldGenerator::try_load(World& world, LightManager& light_manager, glm::ivec2 chunk_index, int radius)
@@ -112,10 +147,18 @@ void WorldGenerator::try_load(World& world, LightManager& light_manager, glm::iv
       if(it == m_chunk_infos.end())
       {
         bool success;
-        std::tie(it, success) = m_chunk_infos.emplace(neighbour_chunk_index, [this, neighbour_chunk_index]() {
-          std::mt19937 prng_global(m_config.seed);
-          std::mt19937 prng_local(hash_combine(m_config.seed, neighbour_chunk_index));
-          return generate_chunk_info(prng_global, prng_local, m_config, neighbour_chunk_index);
+        std::tie(it, success) = m_chunk_infos.try_emplace(neighbour_chunk_index, TaskKind::CHUNK_INFO, [this, neighbour_chunk_index]() {
+          std::mt19937 prng(hash_combine(m_config.seed, neighbour_chunk_index));
+          ChunkInfo chunk_info = generate_chunk_info(prng, m_terrain_sampler, m_config, neighbour_chunk_index);
+
+          // Chunk infos are never dropped, so they only ever add up
+          static MemoryRegistry::Gauge& chunk_info_memory = MemoryRegistry::instance().gauge("world_generator.chunk_infos");
+          size_t bytes = sizeof(ChunkInfo) + chunk_info.height_maps.size() * sizeof(HeightMap);
+          for(const Worm& worm : chunk_info.worms)
+            bytes += sizeof(Worm) + worm.nodes.size() * sizeof(Worm::Node);
+          chunk_info_memory.add(bytes, 1);
+
+          return chunk_info;
         });
         assert(success);
       }
@@ -192,23 +235,18 @@ done:;
         }
     }
 
+  update_occupancy(chunk);
+  update_lod(chunk);
   chunk.mesh_invalidated = true;
 }
 
-template<typename Prng>
-std::vector<WorldGenerator::HeightMap> WorldGenerator::generate_height_maps(Prng& prng, const TerrainGenerationConfig& config, glm::ivec2 chunk_index)
+std::vector<WorldGenerator::HeightMap> WorldGenerator::generate_height_maps(const TerrainSampler& terrain_sampler, glm::ivec2 chunk_index)
 {
-  std::vector<HeightMap> height_maps;
-  for(const LayerGenerationConfig& terrain_layer_config : config.layers)
-  {
-    size_t seed = prng();
-
-    HeightMap height_map;
+  std::vector<HeightMap> height_maps(terrain_sampler.layer_count());
+  for(size_t i=0; i<height_maps.size(); ++i)
     for(int y=0; y<CHUNK_WIDTH; ++y)
       for(int x=0; x<CHUNK_WIDTH; ++x)
-        height_map.heights[y][x] = std::max(terrain_layer_config.height_base + noise(seed, coordinates::local_to_global(glm::vec2(x, y), chunk_index), terrain_layer_config.height_noise), 0.0f);
-    height_maps.push_back(height_map);
-  }
+        height_maps[i].heights[y][x] = terrain_sampler.layer_height(i, coordinates::local_to_global(glm::vec2(x, y), chunk_index));
   return height_maps;
 }
 
@@ -260,10 +298,10 @@ std::vector<WorldGenerator::Worm> WorldGenerator::generate_worms(Prng& prng, con
 }
 
 template<typename Prng>
-WorldGenerator::ChunkInfo WorldGenerator::generate_chunk_info(Prng& prng_global, Prng& prng_local, const WorldGenerationConfig& config, glm::ivec2 chunk_index)
+WorldGenerator::ChunkInfo WorldGenerator::generate_chunk_info(Prng& prng, const TerrainSampler& terrain_sampler, const WorldGenerationConfig& config, glm::ivec2 chunk_index)
 {
-  std::vector<HeightMap> height_maps = generate_height_maps(prng_global, config.terrain, chunk_index);
-  std::vector<Worm>      worms       = generate_worms(prng_local, config.caves, chunk_index);
+  std::vector<HeightMap> height_maps = generate_height_maps(terrain_sampler, chunk_index);
+  std::vector<Worm>      worms       = generate_worms(prng, config.caves, chunk_index);
   return ChunkInfo {
     .height_maps = std::move(height_maps),
     .worms       = std::move(worms),
@@ -2,168 +2,486 @@
 
 #include <coordinates.hpp>
 #include <directions.hpp>
+#include <frustum.hpp>
+#include <profiler.hpp>
+#include <memory_registry.hpp>
 
 #include <GLFW/glfw3.h>
 
-WorldRenderer::WorldRenderer(ResourcePack resource_pack) : m_resource_pack(std::move(resource_pack))
+// ChunkMesh::visible_sections has one bit per section
+static_assert(CHUNK_SECTION_COUNT <= 32);
+
+struct ChunkVertex
+{
+  glm::vec3 position;
+  glm::vec2 texture_coords;
+  uint32_t  texture_index;
+  float     light_ratio;
+  float     destroy_ratio;
+};
+
+struct WorldRenderer::ChunkMeshData
+{
+  int lod;
+  int neighbour_lods[4];
+
+  std::vector<ChunkVertex> vertices;
+  size_t                   section_ends[CHUNK_SECTION_COUNT]; // Number of vertices at the end of every section
+  SectionVisibility        visibilities[CHUNK_SECTION_COUNT];
+};
+
+static constexpr graphics::Attribute CHUNK_VERTEX_ATTRIBUTES[] = {
+  { .type = graphics::AttributeType::FLOAT3,        .offset = offsetof(ChunkVertex, position),       },
+  { .type = graphics::AttributeType::FLOAT2,        .offset = offsetof(ChunkVertex, texture_coords), },
+  { .type = graphics::AttributeType::UNSIGNED_INT1, .offset = offsetof(ChunkVertex, texture_index),  },
+  { .type = graphics::AttributeType::FLOAT1,        .offset = offsetof(ChunkVertex, light_ratio),    },
+  { .type = graphics::AttributeType::FLOAT1,        .offset = offsetof(ChunkVertex, destroy_ratio),  },
+};
+
+WorldRenderer::WorldRenderer(ResourcePack resource_pack, const WorldGenerationConfig& world_generation_config) : m_resource_pack(std::move(resource_pack)), m_stats{}
 {
   m_chunk_shader_program = std::make_unique<graphics::ShaderProgram>("assets/chunk.vert", "assets/chunk.frag");
   m_entity_shader_program = std::make_unique<graphics::ShaderProgram>("assets/entity.vert", "assets/entity.frag");
+
+  static constexpr graphics::Attribute ENTITY_INSTANCE_ATTRIBUTES[] = {
+    { .type = graphics::AttributeType::FLOAT4, .offset = 0 * sizeof(glm::vec4), },
+    { .type = graphics::AttributeType::FLOAT4, .offset = 1 * sizeof(glm::vec4), },
+    { .type = graphics::AttributeType::FLOAT4, .offset = 2 * sizeof(glm::vec4), },
+    { .type = graphics::AttributeType::FLOAT4, .offset = 3 * sizeof(glm::vec4), },
+  };
+  for(EntityResource& entity_resource : m_resource_pack.entities)
+    entity_resource.mesh->set_instance_layout(sizeof(glm::mat4), ENTITY_INSTANCE_ATTRIBUTES);
+  m_entity_instances.resize(m_resource_pack.entities.size());
+
+  m_chunk_arena = std::make_unique<graphics::MeshArena>(sizeof(ChunkVertex), CHUNK_VERTEX_ATTRIBUTES, CHUNK_ARENA_VERTEX_CAPACITY);
+  m_chunk_arena->set_indices(graphics::quad_indices(CHUNK_ARENA_QUAD_CAPACITY));
+
+  m_far_terrain_renderer = std::make_unique<FarTerrainRenderer>(world_generation_config);
 }
 
-void WorldRenderer::render(const graphics::Camera& camera, const World& world, bool third_person, graphics::WireframeRenderer& wireframe_renderer)
+WorldRenderer::~WorldRenderer() = default;
+
+void WorldRenderer::render(const graphics::Camera& camera, const RenderSnapshot& snapshot, bool third_person, graphics::WireframeRenderer& wireframe_renderer)
 {
-  render_chunks(camera, world);
-  render_entites(camera, world, third_person, wireframe_renderer);
+  m_stats = {};
+  upload_chunk_meshes();
+  render_chunks(camera);
+
+  // Chunks are loaded in a circle around the chunk the player is in. Start
+  // the horizon a chunk short of its edge, so that there is no gap.
+  glm::vec2 center       = (glm::floor(glm::vec2(camera.transform.position) / float(CHUNK_WIDTH)) + glm::vec2(0.5f)) * float(CHUNK_WIDTH);
+  float     inner_radius = (WorldGenerator::CHUNK_LOAD_RADIUS - 1) * CHUNK_WIDTH;
+  m_far_terrain_renderer->render(camera, m_resource_pack, center, inner_radius);
+  m_stats.far_terrain = m_far_terrain_renderer->stats();
+
+  render_entites(camera, snapshot, third_person, wireframe_renderer);
 }
 
-void WorldRenderer::render_chunks(const graphics::Camera& camera, const World& world)
+// Chebyshev distance in chunks, so that LOD rings are square like the grid
+static int chunk_lod(glm::ivec2 chunk_index, glm::ivec2 camera_chunk_index)
 {
-  // 1: Mesh building
-  struct Vertex
-  {
-    glm::vec3 position;
-    glm::vec2 texture_coords;
-    uint32_t  texture_index;
-    float     light_ratio;
-    float     destroy_ratio;
-  };
-
-  std::vector<uint32_t> indices;
-  std::vector<Vertex>   vertices;
+  int distance = std::max(std::abs(chunk_index.x - camera_chunk_index.x), std::abs(chunk_index.y - camera_chunk_index.y));
+  int lod      = 0;
+  while(lod + 1 < CHUNK_LOD_COUNT && distance > WorldRenderer::CHUNK_LOD_DISTANCES[lod])
+    ++lod;
+  return lod;
+}
 
-  for(auto& [chunk_index, chunk] : world.chunks)
-    if(chunk.mesh_invalidated)
-    {
-      chunk.mesh_invalidated = false;
+struct FaceCover
+{
+  bool          covered;
+  std::uint32_t light_level;
+};
+
+// Whether the blocks in [origin, origin+dimension), local to the chunk, are
+// all covered by solid cells of the chunk as drawn at the given level, and
+// how much light there is in the cells that are not
+static FaceCover face_cover(const Chunk& chunk, int level, glm::ivec3 origin, glm::ivec3 dimension)
+{
+  FaceCover  cover = { .covered = true, .light_level = 0 };
+  glm::ivec3 first = origin / (1 << level);
+  glm::ivec3 last  = (origin + dimension - glm::ivec3(1)) / (1 << level);
+  for(int z=first.z; z<=last.z; ++z)
+    for(int y=first.y; y<=last.y; ++y)
+      for(int x=first.x; x<=last.x; ++x)
+      {
+        const Block* block = get_lod_block(chunk, level, glm::ivec3(x, y, z));
+        if(block->id == BLOCK_ID_NONE)
+        {
+          cover.covered     = false;
+          cover.light_level = std::max<std::uint32_t>(cover.light_level, block->light_level);
+        }
+      }
+  return cover;
+}
 
-      indices.clear();
-      vertices.clear();
+// Mesh a chunk at the given LOD level. Faces on the border of the chunk are
+// culled against the neighbouring chunk in the same direction, if there is
+// one, as it is drawn at its own LOD, which is what keeps the seams between
+// different LODs closed. section_ends receives the number of vertices at the
+// end of every section.
+static void mesh_chunk(
+  const ResourcePack&       resource_pack,
+  glm::ivec2                chunk_index,
+  const Chunk&              chunk,
+  const Chunk              *(&neighbours)[4],
+  int                       lod,
+  const int                 (&neighbour_lods)[4],
+  std::vector<ChunkVertex>& vertices,
+  size_t                    (&section_ends)[CHUNK_SECTION_COUNT]
+)
+{
+  int        size           = 1 << lod;
+  glm::ivec3 dimension      = lod_dimension(lod);
+  int        section_height = CHUNK_SECTION_HEIGHT >> lod;
+  glm::vec3  chunk_origin   = coordinates::local_to_global(glm::vec3(0.0f), chunk_index);
 
-      for(int lz=0; lz<CHUNK_HEIGHT; ++lz)
-        for(int ly=0; ly<CHUNK_WIDTH; ++ly)
-          for(int lx=0; lx<CHUNK_WIDTH; ++lx)
+  for(int section=0; section<CHUNK_SECTION_COUNT; ++section)
+  {
+    for(int cz=section*section_height; cz<(section+1)*section_height; ++cz)
+      for(int cy=0; cy<dimension.y; ++cy)
+        for(int cx=0; cx<dimension.x; ++cx)
+        {
+          const Block* block = get_lod_block(chunk, lod, glm::ivec3(cx, cy, cz));
+          if(block->id == BLOCK_ID_NONE)
+            continue;
+
+          glm::ivec3 origin = glm::ivec3(cx, cy, cz) * size;
+          for(int i=0; i<std::size(DIRECTIONS); ++i)
           {
-            glm::ivec3   position = coordinates::local_to_global(glm::ivec3(lx, ly, lz), chunk_index);
-            const Block* block    = get_block(world, position);
-            if(block->id == BLOCK_ID_NONE)
-              continue;
-
-            for(int i=0; i<std::size(DIRECTIONS); ++i)
+            glm::ivec3 direction = DIRECTIONS[i];
+
+            // The layer of blocks directly in front of the face
+            glm::ivec3 front_origin    = origin;
+            glm::ivec3 front_dimension = glm::ivec3(size);
+            for(int axis=0; axis<3; ++axis)
+              if(direction[axis] != 0)
+              {
+                front_origin[axis]    += direction[axis] > 0 ? size : -1;
+                front_dimension[axis]  = 1;
+              }
+
+            FaceCover cover = { .covered = false, .light_level = 15 };
+            if(front_origin.z >= 0 && front_origin.z < CHUNK_HEIGHT)
             {
-              glm::ivec3 direction = DIRECTIONS[i];
-
-              glm::ivec3   neighbour_position = position + direction;
-              const Block* neighbour_block    = get_block(world, neighbour_position);
-              if(neighbour_block && neighbour_block->id != BLOCK_ID_NONE)
-                continue;
-
-              uint32_t index_base = vertices.size();
-              indices.push_back(index_base + 0);
-              indices.push_back(index_base + 1);
-              indices.push_back(index_base + 2);
-              indices.push_back(index_base + 2);
-              indices.push_back(index_base + 1);
-              indices.push_back(index_base + 3);
-
-              glm::ivec3 out   = direction;
-              glm::ivec3 up    = direction.z == 0.0 ? glm::ivec3(0, 0, 1) : glm::ivec3(1, 0, 0);
-              glm::ivec3 right = glm::cross(glm::vec3(up), glm::vec3(out));
-              glm::vec3 center = glm::vec3(position) + glm::vec3(0.5f, 0.5f, 0.5f) + 0.5f * glm::vec3(out);
-
-              const BlockResource& block_resource = m_resource_pack.blocks.at(block->id);
-              uint32_t texture_index = block_resource.texture_indices[i];
-              uint32_t light_level   = neighbour_block ? neighbour_block->light_level : 15;
-              uint32_t destroy_level = block->destroy_level;
-
-              float light_ratio   = light_level   / 16.0f;
-              float destroy_ratio = destroy_level / 16.0f;
-
-              vertices.push_back(Vertex{ .position = center + ( - 0.5f * glm::vec3(right) - 0.5f * glm::vec3(up)), .texture_coords = {0.0f, 0.0f}, .texture_index = texture_index, .light_ratio = light_ratio, .destroy_ratio = destroy_ratio, });
-              vertices.push_back(Vertex{ .position = center + ( + 0.5f * glm::vec3(right) - 0.5f * glm::vec3(up)), .texture_coords = {1.0f, 0.0f}, .texture_index = texture_index, .light_ratio = light_ratio, .destroy_ratio = destroy_ratio, });
-              vertices.push_back(Vertex{ .position = center + ( - 0.5f * glm::vec3(right) + 0.5f * glm::vec3(up)), .texture_coords = {0.0f, 1.0f}, .texture_index = texture_index, .light_ratio = light_ratio, .destroy_ratio = destroy_ratio, });
-              vertices.push_back(Vertex{ .position = center + ( + 0.5f * glm::vec3(right) + 0.5f * glm::vec3(up)), .texture_coords = {1.0f, 1.0f}, .texture_index = texture_index, .light_ratio = light_ratio, .destroy_ratio = destroy_ratio, });
-              // NOTE: Brackets added so that it is possible for the compiler to do constant folding if loop is unrolled, not that it would actually do it.
+              if(front_origin.x >= 0 && front_origin.x < CHUNK_WIDTH && front_origin.y >= 0 && front_origin.y < CHUNK_WIDTH)
+                cover = face_cover(chunk, lod, front_origin, front_dimension);
+              else if(const Chunk *neighbour = neighbours[i])
+                cover = face_cover(*neighbour, neighbour_lods[i], coordinates::global_to_local(coordinates::local_to_global(front_origin, chunk_index), chunk_index + glm::ivec2(direction)), front_dimension);
             }
+            if(cover.covered)
+              continue;
+
+            glm::ivec3 out   = direction;
+            glm::ivec3 up    = direction.z == 0.0 ? glm::ivec3(0, 0, 1) : glm::ivec3(1, 0, 0);
+            glm::ivec3 right = glm::cross(glm::vec3(up), glm::vec3(out));
+            glm::vec3 center = chunk_origin + glm::vec3(origin) + 0.5f * float(size) * (glm::vec3(1.0f, 1.0f, 1.0f) + glm::vec3(out));
+
+            const BlockResource& block_resource = resource_pack.blocks.at(block->id);
+            uint32_t texture_index = block_resource.texture_indices[i];
+            uint32_t light_level   = cover.light_level;
+            uint32_t destroy_level = block->destroy_level;
+
+            float light_ratio   = light_level   / 16.0f;
+            float destroy_ratio = destroy_level / 16.0f;
+
+            // Textures repeat, so that every block covered by the face still
+            // gets a whole copy of the texture
+            float extent = 0.5f * float(size);
+            float t      = float(size);
+            vertices.push_back(ChunkVertex{ .position = center + extent * (-glm::vec3(right) - glm::vec3(up)), .texture_coords = {0.0f, 0.0f}, .texture_index = texture_index, .light_ratio = light_ratio, .destroy_ratio = destroy_ratio, });
+            vertices.push_back(ChunkVertex{ .position = center + extent * ( glm::vec3(right) - glm::vec3(up)), .texture_coords = {t,    0.0f}, .texture_index = texture_index, .light_ratio = light_ratio, .destroy_ratio = destroy_ratio, });
+            vertices.push_back(ChunkVertex{ .position = center + extent * (-glm::vec3(right) + glm::vec3(up)), .texture_coords = {0.0f, t   }, .texture_index = texture_index, .light_ratio = light_ratio, .destroy_ratio = destroy_ratio, });
+            vertices.push_back(ChunkVertex{ .position = center + extent * ( glm::vec3(right) + glm::vec3(up)), .texture_coords = {t,    t   }, .texture_index = texture_index, .light_ratio = light_ratio, .destroy_ratio = destroy_ratio, });
           }
+        }
+    section_ends[section] = vertices.size();
+  }
+}
+
+void WorldRenderer::update(const graphics::Camera& camera, const World& world)
+{
+  PROFILE_ZONE("chunk_meshing");
+
+  // Chunks are remeshed when their blocks change, and also when the LOD they
+  // should be drawn at, or that of one of their neighbours, is no longer the
+  // one they were meshed with. The latter happens to whole rings of chunks at
+  // once whenever the camera moves into another chunk, so chunks whose blocks
+  // changed go first. A chunk being remeshed is not remeshed again until that
+  // is done, and stays invalidated if it changes in the meantime.
+  //
+  // Meshing itself runs on the thread pool, from copies of the chunk and of
+  // its neighbours. Copies are shared between the chunks started here.
+  glm::ivec2 camera_chunk_index = glm::floor(glm::vec2(camera.transform.position) / float(CHUNK_WIDTH));
+
+  std::unordered_map<glm::ivec2, std::shared_ptr<const Chunk>> copies;
+  auto copy_chunk = [&](glm::ivec2 chunk_index) -> std::shared_ptr<const Chunk> {
+    auto it = world.chunks.find(chunk_index);
+    if(it == world.chunks.end())
+      return nullptr;
+
+    std::shared_ptr<const Chunk>& copy = copies[chunk_index];
+    if(!copy)
+      copy = std::make_shared<const Chunk>(it->second);
+    return copy;
+  };
 
-      auto it = m_chunk_meshes.find(chunk_index);
-      if(it == m_chunk_meshes.end())
+  for(bool invalidated : { true, false })
+    for(auto& [chunk_index, chunk] : world.chunks)
+    {
+      if(m_pending_chunk_meshes.size() == REMESH_BUDGET)
+        break;
+
+      if(chunk.mesh_invalidated != invalidated || m_pending_chunk_meshes.contains(chunk_index))
+        continue;
+
+      int lod = chunk_lod(chunk_index, camera_chunk_index);
+      int neighbour_lods[4];
+      for(int i=0; i<4; ++i)
+        neighbour_lods[i] = chunk_lod(chunk_index + glm::ivec2(DIRECTIONS[i]), camera_chunk_index);
+
+      if(!invalidated)
       {
-        const graphics::Attribute attributes[] = {
-          { .type = graphics::AttributeType::FLOAT3,        .offset = offsetof(Vertex, position),       },
-          { .type = graphics::AttributeType::FLOAT2,        .offset = offsetof(Vertex, texture_coords), },
-          { .type = graphics::AttributeType::UNSIGNED_INT1, .offset = offsetof(Vertex, texture_index),  },
-          { .type = graphics::AttributeType::FLOAT1,        .offset = offsetof(Vertex, light_ratio),    },
-          { .type = graphics::AttributeType::FLOAT1,        .offset = offsetof(Vertex, destroy_ratio),  },
-        };
-
-        std::unique_ptr<graphics::Mesh> chunk_mesh = std::make_unique<graphics::Mesh>(
-          graphics::IndexType::UNSIGNED_INT,
-          graphics::PrimitiveType::TRIANGLES,
-          sizeof(Vertex),
-          attributes);
-
-        bool success;
-        std::tie(it, success) = m_chunk_meshes.emplace(chunk_index, std::move(chunk_mesh));
-        assert(success);
+        auto it = m_chunk_meshes.find(chunk_index);
+        if(it == m_chunk_meshes.end())
+          continue;
+
+        const ChunkMesh& chunk_mesh = it->second;
+        if(chunk_mesh.lod == lod && std::equal(std::begin(neighbour_lods), std::end(neighbour_lods), std::begin(chunk_mesh.neighbour_lods)))
+          continue;
       }
-      it->second->write(std::as_bytes(std::span(indices)), std::as_bytes(std::span(vertices)), graphics::Usage::DYNAMIC);
+
+      chunk.mesh_invalidated = false;
+
+      std::shared_ptr<const Chunk> chunk_copy = copy_chunk(chunk_index);
+      std::shared_ptr<const Chunk> neighbour_copies[4];
+      for(int i=0; i<4; ++i)
+        neighbour_copies[i] = copy_chunk(chunk_index + glm::ivec2(DIRECTIONS[i]));
+
+      m_pending_chunk_meshes.emplace(chunk_index, std::make_unique<Lazy<ChunkMeshData>>(TaskKind::CHUNK_MESH,
+        [&resource_pack=m_resource_pack, chunk_index, chunk_copy, neighbour_copies, lod, neighbour_lods]() {
+          ChunkMeshData data = { .lod = lod, .neighbour_lods = {}, .vertices = {}, .section_ends = {}, .visibilities = {} };
+          std::copy(std::begin(neighbour_lods), std::end(neighbour_lods), std::begin(data.neighbour_lods));
+
+          const Chunk *neighbours[4];
+          for(int i=0; i<4; ++i)
+            neighbours[i] = neighbour_copies[i].get();
+
+          mesh_chunk(resource_pack, chunk_index, *chunk_copy, neighbours, lod, neighbour_lods, data.vertices, data.section_ends);
+          for(int section=0; section<CHUNK_SECTION_COUNT; ++section)
+            data.visibilities[section] = compute_section_visibility(*chunk_copy, section);
+          return data;
+        }));
+    }
+
+  // Copies made by this update, which live until the meshes started from
+  // them are done
+  static MemoryRegistry::Gauge& chunk_copy_memory = MemoryRegistry::instance().gauge("world_renderer.chunk_copies");
+  chunk_copy_memory.set(copies.size() * sizeof(Chunk), copies.size());
+}
+
+void WorldRenderer::upload_chunk_meshes()
+{
+  PROFILE_ZONE("upload_chunk_meshes");
+
+  for(auto pending_it = m_pending_chunk_meshes.begin(); pending_it != m_pending_chunk_meshes.end();)
+  {
+    auto& [chunk_index, pending] = *pending_it;
+    const ChunkMeshData *data = pending->try_get();
+    if(!data)
+    {
+      ++m_stats.chunk_pending_count;
+      ++pending_it;
+      continue;
     }
 
-  // 2: Rendering
+    auto it = m_chunk_meshes.find(chunk_index);
+    if(it == m_chunk_meshes.end())
+      it = m_chunk_meshes.emplace(chunk_index, ChunkMesh{ .allocation = {}, .lod = 0, .neighbour_lods = {}, .sections = {}, .visibilities = {}, .visible_sections = 0 }).first;
+    else
+      m_chunk_arena->free(it->second.allocation);
+
+    ChunkMesh& chunk_mesh = it->second;
+    chunk_mesh.allocation = m_chunk_arena->allocate(std::as_bytes(std::span(data->vertices)));
+    chunk_mesh.lod        = data->lod;
+    std::copy(std::begin(data->neighbour_lods), std::end(data->neighbour_lods), std::begin(chunk_mesh.neighbour_lods));
+
+    size_t section_begin = 0;
+    for(int section=0; section<CHUNK_SECTION_COUNT; ++section)
+    {
+      chunk_mesh.sections[section].index_offset = section_begin / 4 * 6;
+      chunk_mesh.sections[section].index_count  = (data->section_ends[section] - section_begin) / 4 * 6;
+      chunk_mesh.visibilities[section]          = data->visibilities[section];
+      section_begin = data->section_ends[section];
+    }
+
+    // Every face is a quad, so all chunks share one index buffer that only
+    // needs to be as large as the largest chunk
+    if(size_t index_count = data->vertices.size() / 4 * 6; index_count > m_chunk_arena->index_count())
+      m_chunk_arena->set_indices(graphics::quad_indices(std::max(m_chunk_arena->index_count() * 2, index_count) / 6));
+
+    pending_it = m_pending_chunk_meshes.erase(pending_it);
+  }
+
+  static MemoryRegistry::Gauge& chunk_mesh_memory = MemoryRegistry::instance().gauge("world_renderer.chunk_meshes");
+  chunk_mesh_memory.set(m_chunk_meshes.size() * sizeof(decltype(m_chunk_meshes)::value_type), m_chunk_meshes.size());
+}
+
+void WorldRenderer::render_chunks(const graphics::Camera& camera)
+{
+  PROFILE_ZONE("render_chunks");
+
+  // 1: Rendering
   m_chunk_shader_program->use();
 
   glm::mat4 view       = camera.view();
   glm::mat4 projection = camera.projection();
-  glm::mat4 model      = glm::mat4(1.0f);
-
-  m_chunk_shader_program->set_uniform("MVP", projection * view * model);
-  m_chunk_shader_program->set_uniform("MV",               view * model);
 
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D_ARRAY, m_resource_pack.blocks_texture_array->id());
   m_chunk_shader_program->set_uniform( "blocksTextureArray", 0);
 
-  for(const auto& [chunk_index, mesh] : m_chunk_meshes)
-    mesh->draw();
-}
+  Frustum frustum = Frustum::from_matrix(projection * view);
+  auto section_aabb = [](glm::ivec3 section) {
+    return AABB{
+      .position  = glm::vec3(section.x * CHUNK_WIDTH, section.y * CHUNK_WIDTH, section.z * CHUNK_SECTION_HEIGHT),
+      .dimension = glm::vec3(CHUNK_WIDTH, CHUNK_WIDTH, CHUNK_SECTION_HEIGHT),
+    };
+  };
 
-void WorldRenderer::render_entites(const graphics::Camera& camera, const World& world, bool third_person, graphics::WireframeRenderer& wireframe_renderer)
-{
-  const Player& player = world.players.front();
+  // 2: Occlusion culling. Find the sections that can be seen from the
+  //    camera through empty blocks. If the camera is not in a section we
+  //    have a mesh for, we cannot tell and just skip this step.
+  for(auto& [chunk_index, chunk_mesh] : m_chunk_meshes)
+    chunk_mesh.visible_sections = 0;
 
-  m_entity_shader_program->use();
-  for(size_t i=0; i<world.entities.size(); ++i)
+  glm::ivec3 camera_section = glm::floor(camera.transform.position / glm::vec3(CHUNK_WIDTH, CHUNK_WIDTH, CHUNK_SECTION_HEIGHT));
+  auto get_chunk_mesh = [&](glm::ivec3 section) -> ChunkMesh * {
+    if(section.z < 0 || section.z >= CHUNK_SECTION_COUNT)
+      return nullptr;
+
+    auto it = m_chunk_meshes.find(glm::ivec2(section.x, section.y));
+    return it != m_chunk_meshes.end() ? &it->second : nullptr;
+  };
+
+  bool occlusion_culling = get_chunk_mesh(camera_section);
+  if(occlusion_culling)
+    traverse_visible_sections(camera_section,
+      [&](glm::ivec3 section) -> const SectionVisibility * {
+        ChunkMesh *chunk_mesh = get_chunk_mesh(section);
+        return chunk_mesh ? &chunk_mesh->visibilities[section.z] : nullptr;
+      },
+      [&](glm::ivec3 section) { return frustum.intersects(section_aabb(section)); },
+      [&](glm::ivec3 section) { get_chunk_mesh(section)->visible_sections |= std::uint32_t(1) << section.z; }
+    );
+
+  // 3: Frustum culling. Visible sections that are next to each other in the
+  //    index buffer are merged into a single draw command, and everything is
+  //    drawn with a single call.
+  m_draw_commands.clear();
+  auto push_draw_command = [&](const ChunkMesh& chunk_mesh, size_t first, size_t count) {
+    m_draw_commands.push_back(graphics::DrawElementsIndirectCommand{
+      .count          = static_cast<GLuint>(count),
+      .instance_count = 1,
+      .first_index    = static_cast<GLuint>(first),
+      .base_vertex    = static_cast<GLint>(chunk_mesh.allocation.vertex_offset),
+      .base_instance  = 0,
+    });
+  };
+
+  for(const auto& [chunk_index, chunk_mesh] : m_chunk_meshes)
   {
-    if(!third_person && i == player.entity_id)
+    ++m_stats.chunk_count;
+    ++m_stats.lod_chunk_counts[chunk_mesh.lod];
+    m_stats.lod_vertex_counts[chunk_mesh.lod] += chunk_mesh.allocation.vertex_count;
+
+    size_t non_empty_count = 0;
+    for(const ChunkMesh::Section& section : chunk_mesh.sections)
+      if(section.index_count != 0)
+        ++non_empty_count;
+    m_stats.section_count += non_empty_count;
+
+    glm::vec3 chunk_origin = coordinates::local_to_global(glm::vec3(0.0f), chunk_index);
+    if(!frustum.intersects(AABB{ .position = chunk_origin, .dimension = glm::vec3(CHUNK_WIDTH, CHUNK_WIDTH, CHUNK_HEIGHT) }))
+    {
+      ++m_stats.chunk_culled_count;
+      m_stats.section_culled_count += non_empty_count;
       continue;
+    }
 
-    const Entity&         entity          = world.entities[i];
-    const EntityResource& entity_resource = m_resource_pack.entities.at(entity.id);
+    size_t first = 0;
+    size_t count = 0;
+    for(int i=0; i<CHUNK_SECTION_COUNT; ++i)
+    {
+      const ChunkMesh::Section& section = chunk_mesh.sections[i];
+      if(section.index_count == 0)
+        continue;
 
-    glm::mat4 view       = camera.view();
-    glm::mat4 projection = camera.projection();
-    glm::mat4 model      = entity.transform.as_matrix_no_pitch_roll();
+      if(!frustum.intersects(section_aabb(glm::ivec3(chunk_index, i))))
+      {
+        ++m_stats.section_culled_count;
+        continue;
+      }
 
-    m_entity_shader_program->set_uniform("MVP", projection * view * model);
-    m_entity_shader_program->set_uniform("MV",               view * model);
+      if(occlusion_culling && !(chunk_mesh.visible_sections & (std::uint32_t(1) << i)))
+      {
+        ++m_stats.section_occluded_count;
+        continue;
+      }
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, entity_resource.texture->id());
-    m_entity_shader_program->set_uniform("ourTexture", 0);
-    entity_resource.mesh->draw();
+      if(count != 0 && first + count == section.index_offset)
+        count += section.index_count;
+      else
+      {
+        if(count != 0)
+          push_draw_command(chunk_mesh, first, count);
+        first = section.index_offset;
+        count = section.index_count;
+      }
+    }
+
+    if(count != 0)
+      push_draw_command(chunk_mesh, first, count);
   }
 
-  for(size_t i=0; i<world.entities.size(); ++i)
+  m_chunk_arena->draw(m_draw_commands);
+  m_stats.draw_count      = m_draw_commands.size();
+  m_stats.draw_call_count = m_draw_commands.empty() ? 0 : 1;
+}
+
+void WorldRenderer::render_entites(const graphics::Camera& camera, const RenderSnapshot& snapshot, bool third_person, graphics::WireframeRenderer& wireframe_renderer)
+{
+  for(std::vector<glm::mat4>& instances : m_entity_instances)
+    instances.clear();
+
+  for(size_t i=0; i<snapshot.entities.size(); ++i)
   {
-    if(!third_person && i == player.entity_id)
+    if(!third_person && i == snapshot.player_index)
       continue;
 
-    const Entity& entity = world.entities[i];
+    const RenderSnapshot::Entity& entity = snapshot.entities[i];
+    m_entity_instances.at(entity.id).push_back(entity.transform.as_matrix_no_pitch_roll());
+    ++m_stats.entity_count;
+
+    wireframe_renderer.render_cube(entity.aabb.position, entity.aabb.dimension, glm::vec3(0.6f, 0.6f, 0.6f), 5.0f);
+  }
+
+  m_entity_shader_program->use();
+  m_entity_shader_program->set_uniform("ourTexture", 0);
+  glActiveTexture(GL_TEXTURE0);
 
-    AABB entity_aabb = entity_get_aabb(entity);
-    wireframe_renderer.render_cube(camera, entity_aabb.position, entity_aabb.dimension, glm::vec3(0.6f, 0.6f, 0.6f), 5.0f);
+  for(size_t id=0; id<m_entity_instances.size(); ++id)
+  {
+    const std::vector<glm::mat4>& instances = m_entity_instances[id];
+    if(instances.empty())
+      continue;
+
+    const EntityResource& entity_resource = m_resource_pack.entities[id];
+    entity_resource.mesh->write_instances(std::as_bytes(std::span(instances)), graphics::Usage::STREAM);
+
+    glBindTexture(GL_TEXTURE_2D, entity_resource.texture->id());
+    entity_resource.mesh->draw_instanced(0, instances.size());
+    ++m_stats.entity_draw_call_count;
   }
 }
 
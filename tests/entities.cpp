@@ -0,0 +1,83 @@
+#include "test.hpp"
+
+#include <entities.hpp>
+
+static EntityHandle create_at(Entities& entities, float x)
+{
+  Transform transform = { .position = glm::vec3(x, 0.0f, 0.0f), .rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f) };
+  return entities.create(static_cast<std::uint16_t>(x), transform, glm::vec3(1.0f), 0.5f);
+}
+
+TEST("entities: created entities resolve to their own components")
+{
+  Entities entities;
+  EntityHandle a = create_at(entities, 1.0f);
+  EntityHandle b = create_at(entities, 2.0f);
+  EntityHandle c = create_at(entities, 3.0f);
+  CHECK(entities.size() == 3);
+
+  CHECK(entities.valid(a) && entities.valid(b) && entities.valid(c));
+  CHECK(entities.physics.positions[entities.index(a)].x == 1.0f);
+  CHECK(entities.physics.positions[entities.index(b)].x == 2.0f);
+  CHECK(entities.physics.positions[entities.index(c)].x == 3.0f);
+  CHECK(entities.render.ids[entities.index(c)] == 3);
+
+  for(size_t i=0; i<entities.size(); ++i)
+    CHECK(entities.index(entities.handle(i)) == i);
+}
+
+TEST("entities: destroy moves the last entity into the hole")
+{
+  Entities entities;
+  EntityHandle a = create_at(entities, 1.0f);
+  EntityHandle b = create_at(entities, 2.0f);
+  EntityHandle c = create_at(entities, 3.0f);
+
+  size_t index_a = entities.index(a);
+  entities.destroy(a);
+  CHECK(entities.size() == 2);
+
+  // The stale handle no longer resolves, even though its dense index is now
+  // occupied by the entity that was moved there
+  CHECK(!entities.valid(a));
+  CHECK(entities.index(c) == index_a);
+
+  // The moved entity and the untouched one still resolve to their components
+  CHECK(entities.valid(b) && entities.valid(c));
+  CHECK(entities.physics.positions[entities.index(b)].x == 2.0f);
+  CHECK(entities.physics.positions[entities.index(c)].x == 3.0f);
+  CHECK(entities.render.ids[entities.index(c)] == 3);
+  CHECK(entities.handle(entities.index(c)) == c);
+}
+
+TEST("entities: destroying the last entity")
+{
+  Entities entities;
+  EntityHandle a = create_at(entities, 1.0f);
+  EntityHandle b = create_at(entities, 2.0f);
+  entities.destroy(b);
+  CHECK(!entities.valid(b));
+  CHECK(entities.valid(a));
+  CHECK(entities.size() == 1);
+  CHECK(entities.physics.positions[entities.index(a)].x == 1.0f);
+}
+
+TEST("entities: reused slots get a new generation")
+{
+  Entities entities;
+  EntityHandle a = create_at(entities, 1.0f);
+  entities.destroy(a);
+
+  EntityHandle b = create_at(entities, 2.0f);
+  CHECK(b.slot == a.slot);
+  CHECK(b.generation > a.generation);
+  CHECK(!entities.valid(a));
+  CHECK(entities.valid(b));
+
+  entities.destroy(b);
+  EntityHandle c = create_at(entities, 3.0f);
+  CHECK(c.slot == a.slot);
+  CHECK(c.generation > b.generation);
+  CHECK(!entities.valid(a) && !entities.valid(b));
+  CHECK(entities.physics.positions[entities.index(c)].x == 3.0f);
+}
@@ -0,0 +1,101 @@
+#include "test.hpp"
+
+#include <free_list_allocator.hpp>
+
+TEST("free_list_allocator: exact fit")
+{
+  FreeListAllocator allocator(100);
+  CHECK(allocator.allocate(100) == 0);
+  CHECK(allocator.used() == 100);
+  CHECK(allocator.free_count() == 0);
+  CHECK(allocator.largest_free() == 0);
+}
+
+TEST("free_list_allocator: zero size always fails")
+{
+  FreeListAllocator allocator(100);
+  CHECK(!allocator.allocate(0));
+  CHECK(allocator.used() == 0);
+}
+
+TEST("free_list_allocator: best fit")
+{
+  // Leave free holes of 30, 10 and 20 units, in that order
+  FreeListAllocator allocator(100);
+  auto a = allocator.allocate(30);
+  auto b = allocator.allocate(10);
+  auto c = allocator.allocate(10);
+  auto d = allocator.allocate(10);
+  auto e = allocator.allocate(20);
+  auto f = allocator.allocate(20);
+  CHECK(a && b && c && d && e && f);
+  allocator.free(*a);
+  allocator.free(*c);
+  allocator.free(*e);
+  CHECK(allocator.free_count() == 3);
+
+  // The 10 hole is the smallest that fits 8, not the first or the largest
+  CHECK(allocator.allocate(8) == *c);
+  CHECK(allocator.allocate(15) == *e);
+  CHECK(allocator.allocate(25) == *a);
+}
+
+TEST("free_list_allocator: free coalesces both neighbours")
+{
+  FreeListAllocator allocator(30);
+  auto a = allocator.allocate(10);
+  auto b = allocator.allocate(10);
+  auto c = allocator.allocate(10);
+  CHECK(a == 0 && b == 10 && c == 20);
+
+  allocator.free(*a);
+  allocator.free(*c);
+  CHECK(allocator.free_count() == 2);
+
+  // Freeing the middle range merges it with the free ranges on either side
+  allocator.free(*b);
+  CHECK(allocator.free_count() == 1);
+  CHECK(allocator.largest_free() == 30);
+  CHECK(allocator.used() == 0);
+  CHECK(allocator.allocate(30) == 0);
+}
+
+TEST("free_list_allocator: grow extends the free tail")
+{
+  FreeListAllocator allocator(20);
+  auto a = allocator.allocate(10);
+  CHECK(a == 0);
+  CHECK(!allocator.allocate(20));
+
+  allocator.grow(40);
+  CHECK(allocator.capacity() == 40);
+  CHECK(allocator.free_count() == 1);
+  CHECK(allocator.largest_free() == 30);
+  CHECK(allocator.allocate(30) == 10);
+}
+
+TEST("free_list_allocator: grow from full")
+{
+  FreeListAllocator allocator(10);
+  CHECK(allocator.allocate(10) == 0);
+
+  allocator.grow(15);
+  CHECK(allocator.free_count() == 1);
+  CHECK(allocator.allocate(5) == 10);
+}
+
+TEST("free_list_allocator: out of space")
+{
+  FreeListAllocator allocator(30);
+  auto a = allocator.allocate(10);
+  auto b = allocator.allocate(10);
+  auto c = allocator.allocate(10);
+  CHECK(a && b && c);
+  CHECK(!allocator.allocate(1));
+
+  // Enough space in total, but not in one piece
+  allocator.free(*a);
+  allocator.free(*c);
+  CHECK(!allocator.allocate(20));
+  CHECK(allocator.allocate(10));
+}
@@ -0,0 +1,59 @@
+#include "test.hpp"
+
+#include <frustum.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+static bool near_equal(glm::vec4 a, glm::vec4 b)
+{
+  for(int i=0; i<4; ++i)
+    if(std::abs(a[i] - b[i]) > 1e-5f)
+      return false;
+  return true;
+}
+
+static AABB cube(glm::vec3 center, float size)
+{
+  return AABB{ .position = center - glm::vec3(size * 0.5f), .dimension = glm::vec3(size) };
+}
+
+TEST("frustum: planes of the identity matrix bound the unit cube")
+{
+  // Clip space is [-1, 1] on every axis, so every plane is at distance 1
+  // from the origin, facing inwards
+  Frustum frustum = Frustum::from_matrix(glm::mat4(1.0f));
+  CHECK(near_equal(frustum.planes[0], glm::vec4( 1.0f,  0.0f,  0.0f, 1.0f))); // Left
+  CHECK(near_equal(frustum.planes[1], glm::vec4(-1.0f,  0.0f,  0.0f, 1.0f))); // Right
+  CHECK(near_equal(frustum.planes[2], glm::vec4( 0.0f,  1.0f,  0.0f, 1.0f))); // Bottom
+  CHECK(near_equal(frustum.planes[3], glm::vec4( 0.0f, -1.0f,  0.0f, 1.0f))); // Top
+  CHECK(near_equal(frustum.planes[4], glm::vec4( 0.0f,  0.0f,  1.0f, 1.0f))); // Near
+  CHECK(near_equal(frustum.planes[5], glm::vec4( 0.0f,  0.0f, -1.0f, 1.0f))); // Far
+}
+
+TEST("frustum: boxes against the unit cube")
+{
+  Frustum frustum = Frustum::from_matrix(glm::mat4(1.0f));
+  CHECK( frustum.intersects(cube(glm::vec3(0.0f), 0.5f)));
+  CHECK( frustum.intersects(cube(glm::vec3(0.0f), 10.0f))); // Contains the frustum
+  CHECK( frustum.intersects(cube(glm::vec3(1.0f, 0.0f, 0.0f), 0.5f))); // Straddles a plane
+  CHECK(!frustum.intersects(cube(glm::vec3(2.0f, 0.0f, 0.0f), 0.5f)));
+  CHECK(!frustum.intersects(cube(glm::vec3(0.0f, -2.0f, 0.0f), 0.5f)));
+  CHECK(!frustum.intersects(cube(glm::vec3(0.0f, 0.0f, 2.0f), 0.5f)));
+}
+
+TEST("frustum: boxes against a perspective projection")
+{
+  // Camera at the origin looking down -z, with a 90 degree field of view, so
+  // the side planes are at 45 degrees
+  Frustum frustum = Frustum::from_matrix(glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f));
+  CHECK( frustum.intersects(cube(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f)));
+  CHECK( frustum.intersects(cube(glm::vec3(9.0f, 0.0f, -10.0f), 1.0f)));
+  CHECK(!frustum.intersects(cube(glm::vec3(12.0f, 0.0f, -10.0f), 1.0f)));  // Right
+  CHECK(!frustum.intersects(cube(glm::vec3(0.0f, -12.0f, -10.0f), 1.0f))); // Below
+  CHECK(!frustum.intersects(cube(glm::vec3(0.0f, 0.0f, 10.0f), 1.0f)));    // Behind
+  CHECK(!frustum.intersects(cube(glm::vec3(0.0f, 0.0f, -0.01f), 0.01f)));  // Before the near plane
+  CHECK(!frustum.intersects(cube(glm::vec3(0.0f, 0.0f, -200.0f), 1.0f)));  // Past the far plane
+  CHECK( frustum.intersects(cube(glm::vec3(0.0f, 0.0f, -100.0f), 1.0f)));  // Straddles the far plane
+}
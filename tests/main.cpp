@@ -0,0 +1,37 @@
+#include "test.hpp"
+
+#include <cstdio>
+
+static size_t failure_count = 0;
+
+std::vector<TestCase>& test_cases()
+{
+  static std::vector<TestCase> cases;
+  return cases;
+}
+
+void test_fail(const char *file, int line, const char *expression)
+{
+  std::fprintf(stderr, "  %s:%d: CHECK(%s) failed\n", file, line, expression);
+  ++failure_count;
+}
+
+int main()
+{
+  size_t failed_case_count = 0;
+  for(const TestCase& test_case : test_cases())
+  {
+    size_t previous_failure_count = failure_count;
+    test_case.function();
+    if(failure_count != previous_failure_count)
+    {
+      std::fprintf(stderr, "FAIL %s\n", test_case.name);
+      ++failed_case_count;
+    }
+    else
+      std::fprintf(stderr, "ok   %s\n", test_case.name);
+  }
+
+  std::fprintf(stderr, "%zu/%zu tests passed\n", test_cases().size() - failed_case_count, test_cases().size());
+  return failed_case_count == 0 ? 0 : 1;
+}
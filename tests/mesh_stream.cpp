@@ -0,0 +1,213 @@
+#include "test.hpp"
+
+#include <graphics/mesh.hpp>
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include <string.h>
+
+using namespace graphics;
+
+/*
+ * Just enough of a fake GL for Mesh: buffers live in host memory, and a
+ * simulated GPU runs draws some frames after they were submitted, checking
+ * that the vertices each draw reads are still the ones it was submitted with.
+ * Like a driver, deleted or reallocated storage stays alive for draws still
+ * in flight.
+ */
+namespace fake_gl
+{
+  struct Command
+  {
+    GLsync                 fence; // nullptr for draws
+    const std::byte       *data;
+    std::vector<std::byte> expected;
+  };
+
+  static std::map<GLuint, std::vector<std::byte>> buffers;
+  static std::vector<std::vector<std::byte>>      graveyard;
+  static std::map<GLenum, GLuint>                 bindings;
+  static GLuint                                   next_id;
+
+  static std::deque<Command>   commands;
+  static std::map<GLsync, bool> signaled;
+  static size_t                 fence_count;
+  static size_t                 lag; // In frames
+
+  static std::uint32_t current_frame;
+  static size_t        stale_count;       // Draws reading another frame's data when submitted
+  static size_t        overwritten_count; // Draws whose data changed before the GPU got to it
+
+  static void execute()
+  {
+    Command command = std::move(commands.front());
+    commands.pop_front();
+    if(command.fence)
+      signaled[command.fence] = true;
+    else if(memcmp(command.data, command.expected.data(), command.expected.size()) != 0)
+      ++overwritten_count;
+  }
+
+  static std::vector<std::byte>& reallocate(GLenum target, size_t size)
+  {
+    std::vector<std::byte>& buffer = buffers[bindings[target]];
+    if(!buffer.empty())
+      graveyard.push_back(std::move(buffer));
+    buffer = std::vector<std::byte>(size);
+    return buffer;
+  }
+
+  static void install(size_t frame_lag)
+  {
+    buffers.clear();
+    bindings.clear();
+    commands.clear();
+    signaled.clear();
+    next_id           = 1;
+    fence_count       = 0;
+    lag               = frame_lag;
+    current_frame     = 0;
+    stale_count       = 0;
+    overwritten_count = 0;
+
+    glad_glGenVertexArrays         = [](GLsizei n, GLuint *ids) { for(GLsizei i=0; i<n; ++i) ids[i] = next_id++; };
+    glad_glDeleteVertexArrays      = [](GLsizei, const GLuint*) {};
+    glad_glBindVertexArray         = [](GLuint) {};
+    glad_glEnableVertexAttribArray = [](GLuint) {};
+    glad_glVertexAttribPointer     = [](GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) {};
+    glad_glVertexAttribIPointer    = [](GLuint, GLint, GLenum, GLsizei, const void*) {};
+    glad_glVertexAttribDivisor     = [](GLuint, GLuint) {};
+
+    glad_glGenBuffers    = [](GLsizei n, GLuint *ids) { for(GLsizei i=0; i<n; ++i) buffers[ids[i] = next_id++]; };
+    glad_glDeleteBuffers = [](GLsizei n, const GLuint *ids) {
+      for(GLsizei i=0; i<n; ++i)
+      {
+        graveyard.push_back(std::move(buffers[ids[i]]));
+        buffers.erase(ids[i]);
+      }
+    };
+    glad_glBindBuffer    = [](GLenum target, GLuint id) { bindings[target] = id; };
+    glad_glBufferData    = [](GLenum target, GLsizeiptr size, const void *data, GLenum) {
+      std::vector<std::byte>& buffer = reallocate(target, size);
+      if(data)
+        memcpy(buffer.data(), data, size);
+    };
+    glad_glBufferSubData    = [](GLenum target, GLintptr offset, GLsizeiptr size, const void *data) { memcpy(buffers[bindings[target]].data() + offset, data, size); };
+    glad_glBufferStorage    = [](GLenum target, GLsizeiptr size, const void*, GLbitfield) { reallocate(target, size); };
+    glad_glMapBufferRange   = [](GLenum target, GLintptr offset, GLsizeiptr, GLbitfield) -> void* { return buffers[bindings[target]].data() + offset; };
+
+    // Every fence ends a frame, and the GPU keeps up to lag frames behind
+    glad_glFenceSync = [](GLenum, GLbitfield) -> GLsync {
+      GLsync fence = reinterpret_cast<GLsync>(++fence_count);
+      signaled[fence] = false;
+      commands.push_back(Command{ .fence = fence, .data = nullptr, .expected = {} });
+
+      size_t pending_fence_count = 0;
+      for(const Command& command : commands)
+        pending_fence_count += command.fence != nullptr;
+      for(; pending_fence_count > lag; execute())
+        pending_fence_count -= commands.front().fence != nullptr;
+      return fence;
+    };
+    glad_glClientWaitSync = [](GLsync fence, GLbitfield, GLuint64 timeout) -> GLenum {
+      if(signaled[fence])
+        return GL_ALREADY_SIGNALED;
+      if(timeout == 0)
+        return GL_TIMEOUT_EXPIRED;
+      while(!signaled[fence])
+        execute();
+      return GL_CONDITION_SATISFIED;
+    };
+    glad_glDeleteSync = [](GLsync) {};
+
+    // Vertices are a single uint32_t holding the frame they were written in
+    glad_glDrawElementsBaseVertex = [](GLenum, GLsizei count, GLenum, const void *offset, GLint base_vertex) {
+      const std::byte     *ebo     = buffers[bindings[GL_ELEMENT_ARRAY_BUFFER]].data();
+      const std::byte     *vbo     = buffers[bindings[GL_ARRAY_BUFFER]].data();
+      const std::uint32_t *indices = reinterpret_cast<const std::uint32_t*>(ebo + reinterpret_cast<std::uintptr_t>(offset));
+      for(GLsizei i=0; i<count; ++i)
+      {
+        const std::byte *vertex = vbo + (base_vertex + indices[i]) * sizeof(std::uint32_t);
+
+        std::uint32_t frame;
+        memcpy(&frame, vertex, sizeof frame);
+        if(frame != current_frame)
+          ++stale_count;
+
+        commands.push_back(Command{ .fence = nullptr, .data = vertex, .expected = std::vector<std::byte>(vertex, vertex + sizeof(std::uint32_t)) });
+      }
+    };
+  }
+}
+
+static const Attribute FRAME_ATTRIBUTES[] = {
+  { .type = AttributeType::UNSIGNED_INT1, .offset = 0 },
+};
+
+// Rewrite and draw a mesh every frame, like UIRenderer does, with sizes that
+// grow over the first frames
+static Mesh::Stats run_stream(size_t lag)
+{
+  fake_gl::install(lag);
+
+  Mesh        mesh(IndexType::UNSIGNED_INT, PrimitiveType::TRIANGLES, sizeof(std::uint32_t), FRAME_ATTRIBUTES);
+  Mesh::Stats before = Mesh::total_stats();
+  for(std::uint32_t frame=1; frame<=60; ++frame)
+  {
+    fake_gl::current_frame = frame;
+
+    size_t                     count = 6 + frame % 4 * 3 + (frame < 20 ? frame : 0);
+    std::vector<std::uint32_t> vertices(count, frame);
+    std::vector<std::uint32_t> indices(count);
+    for(size_t i=0; i<count; ++i)
+      indices[i] = i;
+
+    mesh.write(std::as_bytes(std::span(indices)), std::as_bytes(std::span(vertices)), Usage::STREAM);
+    mesh.draw(0, count / 2);
+    mesh.draw(count / 2, count - count / 2);
+  }
+  while(!fake_gl::commands.empty())
+    fake_gl::execute();
+
+  Mesh::Stats after = Mesh::total_stats();
+  return Mesh::Stats{
+    .write_count      = after.write_count      - before.write_count,
+    .allocation_count = after.allocation_count - before.allocation_count,
+    .wait_count       = after.wait_count       - before.wait_count,
+  };
+}
+
+TEST("mesh_stream: ring never waits when the GPU keeps up")
+{
+  Mesh::Stats stats = run_stream(Mesh::STREAM_SEGMENT_COUNT - 1);
+  CHECK(fake_gl::stale_count == 0);
+  CHECK(fake_gl::overwritten_count == 0);
+  CHECK(stats.write_count == 60);
+  CHECK(stats.wait_count == 0);
+}
+
+TEST("mesh_stream: ring waits instead of overwriting when the GPU lags")
+{
+  Mesh::Stats stats = run_stream(Mesh::STREAM_SEGMENT_COUNT + 2);
+  CHECK(fake_gl::stale_count == 0);
+  CHECK(fake_gl::overwritten_count == 0);
+  CHECK(stats.wait_count > 0);
+}
+
+TEST("mesh_stream: orphaned instance buffers count as allocations")
+{
+  fake_gl::install(1);
+
+  Mesh mesh(IndexType::UNSIGNED_INT, PrimitiveType::TRIANGLES, sizeof(std::uint32_t), FRAME_ATTRIBUTES);
+  mesh.set_instance_layout(sizeof(std::uint32_t), FRAME_ATTRIBUTES);
+
+  std::vector<std::uint32_t> instances(16, 1);
+  Mesh::Stats before = Mesh::total_stats();
+  for(int frame=0; frame<10; ++frame)
+    mesh.write_instances(std::as_bytes(std::span(instances)), Usage::STREAM);
+
+  // The first write allocates, and every later one orphans
+  CHECK(Mesh::total_stats().allocation_count - before.allocation_count == 10);
+}
@@ -0,0 +1,91 @@
+#include "test.hpp"
+
+#include <ray_cast.hpp>
+
+#include <random>
+
+// A floor with blocks scattered above it, over a few chunks with holes where
+// chunks are missing, so that rays walk blocks, skip empty sections and cross
+// missing chunks
+static World make_world()
+{
+  std::mt19937                       prng(4);
+  std::uniform_int_distribution<int> scatter(0, 99);
+
+  World world;
+  for(int cy=-2; cy<2; ++cy)
+    for(int cx=-2; cx<2; ++cx)
+    {
+      if((cx + cy) % 3 == 0)
+        continue;
+
+      Chunk& chunk = world.chunks[glm::ivec2(cx, cy)];
+      for(int z=0; z<CHUNK_HEIGHT; ++z)
+        for(int y=0; y<CHUNK_WIDTH; ++y)
+          for(int x=0; x<CHUNK_WIDTH; ++x)
+          {
+            bool solid = z < 20 || (z < 60 && scatter(prng) == 0);
+            chunk.blocks[z][y][x] = Block{ .id = solid ? BLOCK_ID_STONE : BLOCK_ID_NONE, .sky = 0, .light_level = 0, .destroy_level = 0 };
+          }
+      update_occupancy(chunk);
+    }
+  return world;
+}
+
+TEST("ray_cast: batch matches casting each ray on its own")
+{
+  const World world = make_world();
+
+  std::mt19937                          prng(5);
+  std::uniform_real_distribution<float> horizontal(-40.0f, 40.0f);
+  std::uniform_real_distribution<float> vertical(-10.0f, 80.0f);
+  std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+  std::uniform_real_distribution<float> length(0.0f, 100.0f);
+
+  std::vector<Ray> rays;
+  for(int i=0; i<2000; ++i)
+  {
+    glm::vec3 d = glm::vec3(direction(prng), direction(prng), direction(prng));
+    rays.push_back(Ray{ .position = glm::vec3(horizontal(prng), horizontal(prng), vertical(prng)), .direction = d != glm::vec3(0.0f) ? glm::normalize(d) : d, .length = length(prng) });
+  }
+  rays.push_back(Ray{ .position = glm::vec3(0.5f, 0.5f, 10.5f), .direction = glm::vec3(0.0f), .length = 10.0f });
+
+  std::vector<RayCastBlocksResult> results(rays.size());
+  ray_cast_blocks(world, rays, results);
+
+  size_t type_counts[3] = {};
+  for(size_t i=0; i<rays.size(); ++i)
+  {
+    RayCastBlocksResult expected = ray_cast_blocks(world, rays[i].position, rays[i].direction, rays[i].length);
+    CHECK(results[i].type == expected.type);
+    if(expected.type != RayCastBlocksResult::Type::NONE)
+      CHECK(results[i].position == expected.position);
+    if(expected.type == RayCastBlocksResult::Type::HIT)
+      CHECK(results[i].normal == expected.normal);
+    ++type_counts[static_cast<int>(expected.type)];
+  }
+
+  // Every kind of result is covered
+  CHECK(type_counts[0] > 0 && type_counts[1] > 0 && type_counts[2] > 0);
+}
+
+TEST("ray_cast: hit the floor from above")
+{
+  const World world = make_world();
+
+  // Chunk (0, 1) is one of the chunks that exist
+  glm::vec3 position = glm::vec3(0.5f, CHUNK_WIDTH + 0.5f, 100.5f);
+  std::vector<Ray> rays = {
+    Ray{ .position = position, .direction = glm::vec3(0.0f, 0.0f, -1.0f), .length = 200.0f },
+    Ray{ .position = position, .direction = glm::vec3(0.0f, 0.0f, -1.0f), .length = 30.0f },
+  };
+  std::vector<RayCastBlocksResult> results(rays.size());
+  ray_cast_blocks(world, rays, results);
+
+  // The first block down may be one of the scattered ones rather than the floor
+  CHECK(results[0].type == RayCastBlocksResult::Type::HIT);
+  CHECK(results[0].position.x == 0 && results[0].position.y == CHUNK_WIDTH);
+  CHECK(results[0].position.z >= 19 && results[0].position.z < 60);
+  CHECK(results[0].normal == glm::ivec3(0, 0, 1));
+  CHECK(results[1].type == RayCastBlocksResult::Type::NONE);
+}
@@ -0,0 +1,119 @@
+#include "test.hpp"
+
+#include <section_visibility.hpp>
+
+#include <glm/gtx/hash.hpp>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+
+// Chunks are too large for the stack
+static std::unique_ptr<Chunk> make_chunk(std::uint32_t id)
+{
+  auto chunk = std::make_unique<Chunk>();
+  for(int z=0; z<CHUNK_HEIGHT; ++z)
+    for(int y=0; y<CHUNK_WIDTH; ++y)
+      for(int x=0; x<CHUNK_WIDTH; ++x)
+        chunk->blocks[z][y][x] = Block{ .id = id, .sky = 0, .light_level = 0, .destroy_level = 0 };
+  update_occupancy(*chunk);
+  return chunk;
+}
+
+static size_t connection_count(const SectionVisibility& visibility)
+{
+  size_t count = 0;
+  for(int face1=0; face1<SectionVisibility::FACE_COUNT; ++face1)
+    for(int face2=face1+1; face2<SectionVisibility::FACE_COUNT; ++face2)
+      if(visibility.connected(face1, face2))
+        ++count;
+  return count;
+}
+
+TEST("section_visibility: solid section connects nothing")
+{
+  auto chunk = make_chunk(BLOCK_ID_STONE);
+  CHECK(connection_count(compute_section_visibility(*chunk, 1)) == 0);
+}
+
+TEST("section_visibility: empty section connects everything")
+{
+  auto chunk = make_chunk(BLOCK_ID_NONE);
+  SectionVisibility visibility = compute_section_visibility(*chunk, 1);
+  CHECK(connection_count(visibility) == 15);
+}
+
+TEST("section_visibility: tunnel connects only its two faces")
+{
+  // Straight tunnel along x through the middle of section 1, which opens on
+  // the -x and +x faces (faces 0 and 1, as in DIRECTIONS)
+  auto chunk = make_chunk(BLOCK_ID_STONE);
+  for(int x=0; x<CHUNK_WIDTH; ++x)
+    chunk->blocks[CHUNK_SECTION_HEIGHT + 8][8][x].id = BLOCK_ID_NONE;
+  update_occupancy(*chunk);
+
+  SectionVisibility visibility = compute_section_visibility(*chunk, 1);
+  CHECK(visibility.connected(0, 1));
+  CHECK(visibility.connected(1, 0));
+  CHECK(connection_count(visibility) == 1);
+}
+
+TEST("section_visibility: pocket touching one face connects nothing")
+{
+  auto chunk = make_chunk(BLOCK_ID_STONE);
+  for(int x=0; x<4; ++x)
+    chunk->blocks[CHUNK_SECTION_HEIGHT + 8][8][x].id = BLOCK_ID_NONE;
+  update_occupancy(*chunk);
+
+  CHECK(connection_count(compute_section_visibility(*chunk, 1)) == 0);
+}
+
+// Sections along +x from the start section at the bottom of the world, with
+// everything else unavailable
+static std::unordered_set<glm::ivec3> traverse_row(const std::vector<SectionVisibility>& row)
+{
+  std::unordered_map<glm::ivec3, SectionVisibility> visibilities;
+  for(size_t i=0; i<row.size(); ++i)
+    visibilities.emplace(glm::ivec3(i, 0, 0), row[i]);
+
+  std::unordered_set<glm::ivec3> visited;
+  traverse_visible_sections(
+    glm::ivec3(0, 0, 0),
+    [&](glm::ivec3 section) -> const SectionVisibility* {
+      auto it = visibilities.find(section);
+      return it != visibilities.end() ? &it->second : nullptr;
+    },
+    [](glm::ivec3) { return true; },
+    [&](glm::ivec3 section) { CHECK(visited.insert(section).second); }
+  );
+  return visited;
+}
+
+TEST("section_visibility: traversal goes through tunnels")
+{
+  SectionVisibility tunnel;
+  tunnel.connect(0, 1);
+
+  auto visited = traverse_row({ SectionVisibility::all(), tunnel, SectionVisibility::all() });
+  CHECK(visited.size() == 3);
+  CHECK(visited.contains(glm::ivec3(2, 0, 0)));
+}
+
+TEST("section_visibility: traversal stops at sealed walls")
+{
+  // The wall itself can be seen, but nothing behind it
+  auto visited = traverse_row({ SectionVisibility::all(), SectionVisibility(), SectionVisibility::all() });
+  CHECK(visited.size() == 2);
+  CHECK(visited.contains(glm::ivec3(1, 0, 0)));
+  CHECK(!visited.contains(glm::ivec3(2, 0, 0)));
+}
+
+TEST("section_visibility: traversal does not enter through the wrong face")
+{
+  // Connects -y to +y only, so looking at it along x leads nowhere
+  SectionVisibility tunnel;
+  tunnel.connect(2, 3);
+
+  auto visited = traverse_row({ SectionVisibility::all(), tunnel, SectionVisibility::all() });
+  CHECK(!visited.contains(glm::ivec3(2, 0, 0)));
+}
@@ -0,0 +1,113 @@
+#include "test.hpp"
+
+#include <spatial_hash.hpp>
+
+#include <glm/gtx/norm.hpp>
+
+#include <algorithm>
+#include <random>
+
+// Boxes of mixed sizes, some spanning several cells and some on negative
+// coordinates, packed closely enough that many of them overlap
+static std::vector<AABB> make_scene()
+{
+  std::mt19937                          prng(7);
+  std::uniform_real_distribution<float> position(-12.0f, 12.0f);
+  std::uniform_real_distribution<float> dimension(0.2f, 6.0f);
+
+  std::vector<AABB> aabbs;
+  for(int i=0; i<300; ++i)
+    aabbs.push_back(AABB{ .position = glm::vec3(position(prng), position(prng), position(prng)), .dimension = glm::vec3(dimension(prng), dimension(prng), dimension(prng)) });
+  return aabbs;
+}
+
+static std::vector<std::uint32_t> sorted(std::vector<std::uint32_t> indices)
+{
+  std::sort(indices.begin(), indices.end());
+  return indices;
+}
+
+TEST("spatial_hash: query_pairs matches brute force")
+{
+  std::vector<AABB> aabbs = make_scene();
+  SpatialHash spatial_hash;
+  spatial_hash.rebuild(aabbs);
+
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> expected;
+  for(std::uint32_t i=0; i<aabbs.size(); ++i)
+    for(std::uint32_t j=i+1; j<aabbs.size(); ++j)
+      if(aabb_overlap(aabbs[i], aabbs[j]))
+        expected.emplace_back(i, j);
+
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> pairs;
+  spatial_hash.query_pairs(pairs);
+  CHECK(!expected.empty());
+  CHECK(pairs == expected);
+}
+
+TEST("spatial_hash: query_aabb matches brute force")
+{
+  std::vector<AABB> aabbs = make_scene();
+  SpatialHash spatial_hash;
+  spatial_hash.rebuild(aabbs);
+
+  std::mt19937                          prng(8);
+  std::uniform_real_distribution<float> position(-16.0f, 16.0f);
+  std::uniform_real_distribution<float> dimension(0.1f, 10.0f);
+  for(int n=0; n<50; ++n)
+  {
+    AABB query = { .position = glm::vec3(position(prng), position(prng), position(prng)), .dimension = glm::vec3(dimension(prng), dimension(prng), dimension(prng)) };
+
+    std::vector<std::uint32_t> expected;
+    for(std::uint32_t i=0; i<aabbs.size(); ++i)
+      if(aabb_overlap(aabbs[i], query))
+        expected.push_back(i);
+
+    // Reported exactly once, so sorting must not hide any duplicate
+    std::vector<std::uint32_t> result;
+    spatial_hash.query_aabb(query, result);
+    CHECK(result.size() == expected.size());
+    CHECK(sorted(result) == expected);
+  }
+}
+
+TEST("spatial_hash: query_radius matches brute force")
+{
+  std::vector<AABB> aabbs = make_scene();
+  SpatialHash spatial_hash;
+  spatial_hash.rebuild(aabbs);
+
+  std::mt19937                          prng(9);
+  std::uniform_real_distribution<float> position(-16.0f, 16.0f);
+  std::uniform_real_distribution<float> radius(0.5f, 8.0f);
+  for(int n=0; n<50; ++n)
+  {
+    glm::vec3 center = glm::vec3(position(prng), position(prng), position(prng));
+    float     r      = radius(prng);
+
+    std::vector<std::uint32_t> expected;
+    for(std::uint32_t i=0; i<aabbs.size(); ++i)
+    {
+      glm::vec3 closest = glm::clamp(center, aabbs[i].position, aabbs[i].position + aabbs[i].dimension);
+      if(glm::length2(closest - center) <= r * r)
+        expected.push_back(i);
+    }
+
+    std::vector<std::uint32_t> result;
+    spatial_hash.query_radius(center, r, result);
+    CHECK(result.size() == expected.size());
+    CHECK(sorted(result) == expected);
+  }
+}
+
+TEST("spatial_hash: results are appended")
+{
+  std::vector<AABB> aabbs = make_scene();
+  SpatialHash spatial_hash;
+  spatial_hash.rebuild(aabbs);
+
+  std::vector<std::uint32_t> result = { 12345 };
+  spatial_hash.query_aabb(aabbs[0], result);
+  CHECK(result.size() >= 2);
+  CHECK(result[0] == 12345);
+}
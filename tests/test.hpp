@@ -0,0 +1,36 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+/*
+ * Just enough of a test framework for CPU-side code that does not need a GL
+ * context. TEST registers a function that is run by tests/main.cpp, and CHECK
+ * reports a failure and keeps going, so one run shows every broken check.
+ */
+struct TestCase
+{
+  const char            *name;
+  std::function<void()>  function;
+};
+
+std::vector<TestCase>& test_cases();
+void test_fail(const char *file, int line, const char *expression);
+
+struct TestRegistration
+{
+  TestRegistration(const char *name, std::function<void()> function)
+  {
+    test_cases().push_back(TestCase{ .name = name, .function = std::move(function) });
+  }
+};
+
+#define TEST_CONCAT_IMPL(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_IMPL(a, b)
+
+#define TEST(name)                                                                     \
+  static void TEST_CONCAT(test_, __LINE__)();                                          \
+  static TestRegistration TEST_CONCAT(test_registration_, __LINE__)(name, TEST_CONCAT(test_, __LINE__)); \
+  static void TEST_CONCAT(test_, __LINE__)()
+
+#define CHECK(expression) do { if(!(expression)) test_fail(__FILE__, __LINE__, #expression); } while(0)
@@ -0,0 +1,79 @@
+#include "test.hpp"
+
+#include <timer.hpp>
+
+using namespace std::chrono_literals;
+
+// Far from the clock's epoch, as steady_clock is after a long uptime
+static const Timer::Clock::time_point START = Timer::Clock::time_point{} + 24h * 365 * 5;
+
+TEST("timer: a single step is due once a step has elapsed")
+{
+  Timer timer(50ms, 5, START);
+  CHECK(timer.poll(START) == 0);
+  CHECK(timer.poll(START + 49ms) == 0);
+  CHECK(timer.poll(START + 50ms) == 1);
+  CHECK(timer.last_tick() == START + 50ms);
+  CHECK(timer.next_tick() == START + 100ms);
+
+  // Nothing more is due until the next step
+  CHECK(timer.poll(START + 99ms) == 0);
+  CHECK(timer.poll(START + 100ms) == 1);
+  CHECK(timer.stats().dropped_tick_count == 0);
+}
+
+TEST("timer: steps missed during a stall are caught up on")
+{
+  Timer timer(50ms, 5, START);
+  CHECK(timer.poll(START + 210ms) == 4);
+  CHECK(timer.stats().dropped_tick_count == 0);
+
+  // The schedule stays aligned to the start time rather than to the poll
+  CHECK(timer.last_tick() == START + 200ms);
+  CHECK(timer.next_tick() == START + 250ms);
+}
+
+TEST("timer: steps beyond max_catch_up are dropped and counted")
+{
+  Timer timer(50ms, 5, START);
+  CHECK(timer.poll(START + 1000ms) == 5);
+  CHECK(timer.stats().dropped_tick_count == 15);
+  CHECK(timer.next_tick() == START + 1050ms);
+
+  // Dropped steps are not owed later
+  CHECK(timer.poll(START + 1049ms) == 0);
+  CHECK(timer.poll(START + 1050ms) == 1);
+  CHECK(timer.stats().dropped_tick_count == 15);
+
+  CHECK(timer.poll(START + 1400ms) == 5);
+  CHECK(timer.stats().dropped_tick_count == 17);
+}
+
+TEST("timer: lateness is how long after being due a poll happened")
+{
+  Timer timer(50ms, 5, START);
+  timer.poll(START + 60ms);
+  CHECK(timer.stats().last_lateness == 10ms);
+  CHECK(timer.stats().max_lateness  == 10ms);
+
+  timer.poll(START + 103ms);
+  CHECK(timer.stats().last_lateness == 3ms);
+  CHECK(timer.stats().max_lateness  == 10ms);
+
+  // Lateness is measured from the oldest step that was due
+  timer.poll(START + 390ms);
+  CHECK(timer.stats().last_lateness == 240ms);
+  CHECK(timer.stats().max_lateness  == 240ms);
+}
+
+TEST("timer: recorded ticks add up")
+{
+  Timer timer(50ms, 5, START);
+  timer.record_tick(3ms);
+  timer.record_tick(7ms);
+  timer.record_tick(2ms);
+  CHECK(timer.stats().tick_count          == 3);
+  CHECK(timer.stats().last_tick_duration  == 2ms);
+  CHECK(timer.stats().max_tick_duration   == 7ms);
+  CHECK(timer.stats().total_tick_duration == 12ms);
+}
@@ -0,0 +1,122 @@
+#include "test.hpp"
+
+#include <graphics/ui_batch.hpp>
+
+#include <vector>
+
+using graphics::Glyph;
+using graphics::Texture;
+using graphics::UIBatch;
+
+// UIBatch only ever compares textures by address, so stand-ins that are
+// never dereferenced are enough and keep GL out of the test
+static const Texture& fake_texture(const int& storage)
+{
+  return *reinterpret_cast<const Texture*>(&storage);
+}
+
+static const int texture_a_storage = 0;
+static const int texture_b_storage = 0;
+static const Texture& texture_a = fake_texture(texture_a_storage);
+static const Texture& texture_b = fake_texture(texture_b_storage);
+
+static std::vector<Glyph> make_glyphs()
+{
+  std::vector<Glyph> glyphs(128, Glyph{});
+  glyphs['a'] = Glyph{
+    .dimension   = glm::vec2(8.0f, 10.0f),
+    .bearing     = glm::vec2(1.0f, -2.0f),
+    .advance     = glm::vec2(9.0f, 0.0f),
+    .texture_min = glm::vec2(0.0f, 0.0f),
+    .texture_max = glm::vec2(0.5f, 0.5f),
+  };
+  glyphs[' '] = Glyph{
+    .dimension   = glm::vec2(0.0f, 0.0f),
+    .bearing     = glm::vec2(0.0f, 0.0f),
+    .advance     = glm::vec2(4.0f, 0.0f),
+    .texture_min = glm::vec2(0.0f, 0.0f),
+    .texture_max = glm::vec2(0.0f, 0.0f),
+  };
+  return glyphs;
+}
+
+TEST("ui_batch: text follows advance and bearing")
+{
+  std::vector<Glyph> glyphs = make_glyphs();
+
+  UIBatch batch;
+  batch.push_text(glyphs, texture_a, glm::vec2(100.0f, 50.0f), "aa");
+  CHECK(batch.vertices().size() == 8);
+  CHECK(batch.indices().size() == 12);
+
+  // Bottom left corner of each quad is the pen position plus the bearing
+  CHECK(batch.vertices()[0].position == glm::vec2(101.0f, 48.0f));
+  CHECK(batch.vertices()[4].position == glm::vec2(110.0f, 48.0f));
+  CHECK(batch.vertices()[7].position == glm::vec2(118.0f, 58.0f));
+}
+
+TEST("ui_batch: spaces advance without a quad")
+{
+  std::vector<Glyph> glyphs = make_glyphs();
+
+  UIBatch batch;
+  batch.push_text(glyphs, texture_a, glm::vec2(0.0f, 0.0f), "a a");
+  CHECK(batch.vertices().size() == 8);
+  CHECK(batch.vertices()[4].position == glm::vec2(9.0f + 4.0f + 1.0f, -2.0f));
+}
+
+TEST("ui_batch: texture coordinates are flipped vertically")
+{
+  UIBatch batch;
+  batch.push_quad(texture_a, glm::vec2(0.0f, 0.0f), glm::vec2(2.0f, 3.0f), glm::vec2(0.25f, 0.5f), glm::vec2(0.75f, 1.0f));
+
+  const std::vector<UIBatch::Vertex>& vertices = batch.vertices();
+  CHECK(vertices.size() == 4);
+  CHECK(vertices[0].position   == glm::vec2(0.0f, 0.0f));
+  CHECK(vertices[0].tex_coords == glm::vec2(0.25f, 1.0f));
+  CHECK(vertices[1].position   == glm::vec2(2.0f, 0.0f));
+  CHECK(vertices[1].tex_coords == glm::vec2(0.75f, 1.0f));
+  CHECK(vertices[2].position   == glm::vec2(0.0f, 3.0f));
+  CHECK(vertices[2].tex_coords == glm::vec2(0.25f, 0.5f));
+  CHECK(vertices[3].position   == glm::vec2(2.0f, 3.0f));
+  CHECK(vertices[3].tex_coords == glm::vec2(0.75f, 0.5f));
+
+  const std::vector<uint32_t> expected_indices = { 0, 1, 2, 2, 1, 3 };
+  CHECK(batch.indices() == expected_indices);
+}
+
+TEST("ui_batch: runs split when the texture changes")
+{
+  const glm::vec2 zero(0.0f, 0.0f);
+  const glm::vec2 one(1.0f, 1.0f);
+
+  UIBatch batch;
+  batch.push_quad(texture_a, zero, one, zero, one);
+  batch.push_quad(texture_a, zero, one, zero, one);
+  batch.push_quad(texture_b, zero, one, zero, one);
+  batch.push_quad(texture_a, zero, one, zero, one);
+
+  const std::vector<UIBatch::Run>& runs = batch.runs();
+  CHECK(runs.size() == 3);
+  CHECK(runs[0].texture == &texture_a && runs[0].first_index == 0  && runs[0].index_count == 12);
+  CHECK(runs[1].texture == &texture_b && runs[1].first_index == 12 && runs[1].index_count == 6);
+  CHECK(runs[2].texture == &texture_a && runs[2].first_index == 18 && runs[2].index_count == 6);
+
+  // Index bases keep counting across runs, since they share one buffer
+  CHECK(batch.indices()[18] == 12);
+}
+
+TEST("ui_batch: clear empties the batch")
+{
+  const glm::vec2 zero(0.0f, 0.0f);
+  const glm::vec2 one(1.0f, 1.0f);
+
+  UIBatch batch;
+  batch.push_quad(texture_a, zero, one, zero, one);
+  CHECK(!batch.empty());
+
+  batch.clear();
+  CHECK(batch.empty());
+  CHECK(batch.vertices().empty());
+  CHECK(batch.indices().empty());
+}